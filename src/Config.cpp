@@ -2,9 +2,11 @@
 // Created by qm210 on 14.05.2025.
 //
 
+#include <algorithm>
 #include <fstream>
 #include <format>
 #include <iostream>
+#include <sstream>
 #include <getopt.h>
 #include "Config.h"
 #include "FileHelper.h"
@@ -33,6 +35,21 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
         ledBlurSamples, ledBlurRadius, ledBlurPrecision, ledBlurMixing
 )
 
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+        DmxUniverseMapping,
+        universe, channel, led, count
+)
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+        DmxSettings,
+        sacn, artNet, universes
+)
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+        PlayoutSettings,
+        enabled, minDelayMs, maxDelayMs, smoothness
+)
+
 inline void overwrite_if_path_exists(int opt, int targetOpt, std::string& target) {
     if (opt != targetOpt) {
         return;
@@ -48,9 +65,10 @@ Config::Config(int argc, char **argv) {
     std::string configFilename = defaultFilename;
     std::string overwriteVertexShaderPath;
     std::string overwriteFragmentShaderPath;
+    std::vector<std::string> relayAlsoTo;
 
     int opt;
-    while ((opt = getopt(argc, argv, "c:f:v:")) != -1) {
+    while ((opt = getopt(argc, argv, "c:f:v:r:p:s:R:B:")) != -1) {
         if (opt == '?') {
             std::cerr << "Invalid option: " << opt << std::endl;
             continue;
@@ -58,6 +76,33 @@ Config::Config(int argc, char **argv) {
         overwrite_if_path_exists(opt, 'c', configFilename);
         overwrite_if_path_exists(opt, 'f', overwriteFragmentShaderPath);
         overwrite_if_path_exists(opt, 'v', overwriteVertexShaderPath);
+        overwrite_if_path_exists(opt, 'p', replayPath);
+        if (opt == 'r') {
+            recordPath = optarg;
+        }
+        if (opt == 'R') {
+            relayMode = true;
+            std::stringstream list(optarg);
+            for (std::string destination; std::getline(list, destination, ',');) {
+                if (!destination.empty()) {
+                    relayAlsoTo.push_back(destination);
+                }
+            }
+        }
+        if (opt == 'B') {
+            try {
+                benchmarkFrames = std::max(std::stoi(optarg), 1);
+            } catch (const std::exception&) {
+                std::cerr << "Ignore given benchmark frames, as it is no number: " << optarg << std::endl;
+            }
+        }
+        if (opt == 's') {
+            try {
+                replaySpeed = std::max(std::stod(optarg), 0.);
+            } catch (const std::exception&) {
+                std::cerr << "Ignore given replay speed, as it is no number: " << optarg << std::endl;
+            }
+        }
     }
 
     path = std::filesystem::path(configFilename);
@@ -69,6 +114,7 @@ Config::Config(int argc, char **argv) {
     if (!overwriteFragmentShaderPath.empty()) {
         customFragmentShaderPath = overwriteFragmentShaderPath;
     }
+    relayTo.insert(relayTo.end(), relayAlsoTo.begin(), relayAlsoTo.end());
 }
 
 void Config::restore(GLFWwindow* window) {
@@ -137,11 +183,28 @@ bool Config::tryReadFile() {
             customVertexShaderPath = jShaders.value("vertex", "");
             customFragmentShaderPath = jShaders.value("fragment", "");
             hotReloadShaders = jShaders.value("reload", hotReloadShaders);
+            uniformUpload = jShaders.value("uniformUpload", uniformUpload);
             useLogoDevelShader = jShaders.value("useLogoDevelShader", useLogoDevelShader);
             logoDevelShaderPath = jShaders.value("logoDevel", logoDevelShaderPath);
         }
 
         udpPort = currentJson->value("udpPort", udpPort);
+        udpBackend = currentJson->value("udpBackend", udpBackend);
+        udpLedCount = currentJson->value("udpLedCount", udpLedCount);
+        ddpPort = currentJson->value("ddpPort", ddpPort);
+        udpFrameCommit = currentJson->value("udpFrameCommit", udpFrameCommit);
+        udpFrameGapMs = currentJson->value("udpFrameGapMs", udpFrameGapMs);
+        udpExtraPorts = currentJson->value("udpExtraPorts", udpExtraPorts);
+        udpSeparateSenders = currentJson->value("udpSeparateSenders", udpSeparateSenders);
+        sharedFrames = currentJson->value("sharedFrames", sharedFrames);
+        liveview = currentJson->value("liveview", liveview);
+        relayTo = currentJson->value("relayTo", relayTo);
+        if (currentJson->contains("playout")) {
+            playout = currentJson->at("playout").get<PlayoutSettings>();
+        }
+        if (currentJson->contains("dmx")) {
+            dmx = currentJson->at("dmx").get<DmxSettings>();
+        }
         usePrototyper = currentJson->value("usePrototyper", usePrototyper);
 
         return true;
@@ -171,10 +234,23 @@ void Config::store(GLFWwindow* window, ShaderState* state) const {
        {"vertex", customVertexShaderPath},
        {"fragment", customFragmentShaderPath},
        {"reload", hotReloadShaders},
+       {"uniformUpload", uniformUpload},
        {"useLogoDevelShader", useLogoDevelShader},
        {"logoDevel", logoDevelShaderPath},
     };
     j["udpPort"] = udpPort;
+    j["udpBackend"] = udpBackend;
+    j["udpLedCount"] = udpLedCount;
+    j["dmx"] = dmx;
+    j["ddpPort"] = ddpPort;
+    j["udpFrameCommit"] = udpFrameCommit;
+    j["udpFrameGapMs"] = udpFrameGapMs;
+    j["udpExtraPorts"] = udpExtraPorts;
+    j["udpSeparateSenders"] = udpSeparateSenders;
+    j["sharedFrames"] = sharedFrames;
+    j["liveview"] = liveview;
+    j["relayTo"] = relayTo;
+    j["playout"] = playout;
     j["usePrototyper"] = usePrototyper;
 
     if (state != nullptr) {
@@ -206,6 +282,10 @@ void Config::store(GLFWwindow* window, ShaderState* state) const {
         }
 
         file << j.dump(4);
+        file.close();
+
+        std::error_code ignored;
+        storedAt = std::filesystem::last_write_time(path, ignored);
 
     } catch (const std::exception& e) {
         std::cerr << "Error storing Config: " << e.what() << std::endl;
@@ -248,4 +328,29 @@ void Config::restore(ShaderState* state) {
         state->trophy->rebuild();
     }
 
-}
\ No newline at end of file
+}
+
+bool Config::reread(ShaderState* state) {
+    std::error_code error;
+    const auto modifiedAt = std::filesystem::last_write_time(path, error);
+    if (error || modifiedAt == storedAt) {
+        return false;
+    }
+    try {
+        auto fresh = tryReadJson();
+        if (!fresh.has_value()) {
+            return false;
+        }
+        currentJson = fresh;
+        json jShaders = (*currentJson)["shaders"];
+        if (jShaders.is_object()) {
+            hotReloadShaders = jShaders.value("reload", hotReloadShaders);
+        }
+        restore(state);
+        return true;
+    } catch (const std::exception& e) {
+        // e.g. saved in the middle of typing, the next save will do
+        std::cerr << "Error re-reading Config: " << e.what() << std::endl;
+    }
+    return false;
+}
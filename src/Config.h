@@ -6,12 +6,16 @@
 #define DLTROPHY_SIMULATOR_CONFIG_H
 
 #include <string>
+#include <vector>
 #include <filesystem>
 #include <GLFW/glfw3.h>
 #include <glm/vec4.hpp>
 #include <nlohmann/json.hpp>
 #include "geometryHelpers.h"
 #include "ShaderState.h"
+#include "DmxInterpreter.h"
+#include "PlayoutBuffer.h"
+#include "RelaySettings.h"
 
 class Config {
 public:
@@ -24,10 +28,51 @@ public:
     };
 
     int udpPort = 3413;
+    std::string udpBackend = "socket";
+    // <-- "io_uring" is available on Linux, falls back to "socket" if not.
+    int udpLedCount = 0;
+    // <-- how many LEDs the receiver accepts (up to 65536), for senders that drive more than one trophy.
+    //     0 (or below) means: as many as the trophy has. Only the trophy's LEDs are drawn, of course.
+    DmxSettings dmx;
+    // <-- sACN / Art-Net, with their universes mapped onto the LEDs
+    int ddpPort = 0;
+    // <-- WLED's DDP output (which sends to 4048), 0 is off so that nobody gets a port opened they did not ask for
+    std::string udpFrameCommit = "wrap";
+    // <-- when WARLS / DRGB / DNRGB packets make up a frame: "packet" (each one), "wrap" (the next starts
+    //     at or before the previous) or "complete" (every LED was written)
+    int udpFrameGapMs = 2;
+    // <-- also a frame when nothing came for that long, 0 to only go by the rule above
+    std::vector<int> udpExtraPorts;
+    // <-- listened on as well, e.g. one per trophy if the senders can not be told apart otherwise
+    std::string udpSeparateSenders = "address";
+    // <-- every sender gets its own LEDs: "address" (per IP, i.e. per ESP32), "address+port"
+    //     (several senders on one machine) or "none" (everything lands on the same LEDs)
+    std::string sharedFrames;
+    // <-- e.g. "/dltrophy", reads the frames local tools write into that shared memory (Linux / macOS only)
+    std::string liveview;
+    // <-- host of a stock WLED device, its websocket liveview is one more source. Empty means off.
+    PlayoutSettings playout;
+    // <-- evens out frames that arrive in bursts, at the cost of some delay
+
+    std::string recordPath;
+    // <-- -r <file> on the command line, records every received packet there
+    std::string replayPath;
+    // <-- -p <file>, plays such a recording instead of listening on the sockets
+    double replaySpeed = 1;
+    // <-- -s <factor>, 0 is as fast as possible. None of these three go into the config file.
+    std::vector<std::string> relayTo;
+    // <-- "host" or "host:port", where the relay mode sends everything it receives
+    bool relayMode = false;
+    // <-- -R [host:port,...] on the command line: no window, only receive and send on (to these as well)
+    int benchmarkFrames = 0;
+    // <-- -B <frames>: renders fixtures of 172, 1000 and 5000 LEDs that many frames each, prints the times, quits
 
     std::string customVertexShaderPath;
     std::string customFragmentShaderPath;
     bool hotReloadShaders = true;
+    std::string uniformUpload = "persistent";
+    // <-- how the per-frame state gets to the GPU: "persistent" (mapped once, falls back to "orphaning"
+    //     before GL 4.4), "orphaning" or "subdata" (the old way, only to compare)
     bool useLogoDevelShader = false;
     std::string logoDevelShaderPath = "";
 
@@ -35,9 +80,20 @@ public:
 
     Config(int argc, char* argv[]);
 
+    [[nodiscard]]
+    RelaySettings relaySettings() const {
+        return {
+            .ports = {udpPort, ddpPort},
+            .destinations = relayTo,
+        };
+    }
+
     void store(GLFWwindow* window, ShaderState* state = nullptr) const;
     void restore(GLFWwindow* window);
     void restore(ShaderState* state);
+    bool reread(ShaderState* state);
+    // <-- when the file was edited while running: takes the params, options, trophy and "reload" again.
+    //     Everything else only counts from the next start. false if it was our own store() or is unreadable.
 
     [[nodiscard]]
     bool wasRead() const { return currentJson != std::nullopt; };
@@ -66,6 +122,8 @@ public:
 private:
     bool tryReadFile();
     std::optional<nlohmann::json> currentJson;
+    mutable std::optional<std::filesystem::file_time_type> storedAt;
+    // <-- so that reread() can tell our own writes from the ones of an editor
 
     [[nodiscard]]
     std::optional<nlohmann::json> tryReadJson() const;
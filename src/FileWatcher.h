@@ -0,0 +1,241 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_FILEWATCHER_H
+#define DLTROPHY_SIMULATOR_FILEWATCHER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+class FileWatcher {
+    /*
+     *  Tells the main loop which of the watched files (shaders, the config, ...) changed, so that it does not
+     *  have to stat() them every frame. On its own thread: on Linux via inotify on the directories of the files,
+     *  which also catches editors that save by renaming a new file over the old one; elsewhere (or for the
+     *  directories inotify fails on) it compares the modification times a few times per second.
+     *
+     *  Editors tend to write in several steps, so a file is only reported once it was quiet for `debounce`.
+     */
+
+private:
+    static constexpr auto pollInterval = std::chrono::milliseconds(250);
+    static constexpr int waitTimeoutMs = 50;
+
+    const std::chrono::milliseconds debounce;
+
+    struct Directory {
+        std::filesystem::path path;
+        int descriptor = -1;
+        std::map<std::string, std::string> files;
+        // <-- file name in there -> path as it was given to watch()
+    };
+
+    std::mutex mutex;
+    std::vector<Directory> directories;
+    std::map<std::string, std::optional<std::filesystem::file_time_type>> modifiedAt;
+    // <-- only the files that are polled, i.e. not in a directory that inotify watches
+    std::map<std::string, std::chrono::steady_clock::time_point> pending;
+    std::set<std::string> ready;
+
+    int inotifyFd = -1;
+    std::atomic<bool> running{true};
+    std::thread thread;
+
+    static std::optional<std::filesystem::file_time_type> modificationOf(const std::string& path) {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error) {
+            return std::nullopt;
+        }
+        return time;
+    }
+
+    // under the mutex
+    void touched(const std::string& path) {
+        pending[path] = std::chrono::steady_clock::now();
+    }
+
+    // under the mutex
+    void settle() {
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (now - it->second >= debounce) {
+                ready.insert(it->first);
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void pollModificationTimes() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [path, known] : modifiedAt) {
+            auto current = modificationOf(path);
+            if (current != known) {
+                known = current;
+                touched(path);
+            }
+        }
+    }
+
+#ifdef __linux__
+    void readEvents() {
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            const auto length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                if (event->len == 0) {
+                    continue;
+                }
+                for (const auto& directory : directories) {
+                    if (directory.descriptor != event->wd) {
+                        continue;
+                    }
+                    auto file = directory.files.find(event->name);
+                    if (file != directory.files.end()) {
+                        touched(file->second);
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    void run() {
+        auto polledAt = std::chrono::steady_clock::now();
+        while (running) {
+#ifdef __linux__
+            if (inotifyFd >= 0) {
+                pollfd entry{.fd = inotifyFd, .events = POLLIN, .revents = 0};
+                if (::poll(&entry, 1, waitTimeoutMs) > 0) {
+                    readEvents();
+                }
+            } else
+#endif
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(waitTimeoutMs));
+            }
+            if (std::chrono::steady_clock::now() - polledAt >= pollInterval) {
+                pollModificationTimes();
+                polledAt = std::chrono::steady_clock::now();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            settle();
+        }
+    }
+
+    // under the mutex
+    void unwatchAll() {
+#ifdef __linux__
+        for (const auto& directory : directories) {
+            if (directory.descriptor >= 0) {
+                inotify_rm_watch(inotifyFd, directory.descriptor);
+            }
+        }
+#endif
+        directories.clear();
+        modifiedAt.clear();
+        pending.clear();
+    }
+
+public:
+    explicit FileWatcher(std::chrono::milliseconds debounce = std::chrono::milliseconds(100))
+    : debounce(debounce) {
+#ifdef __linux__
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0) {
+            std::cout << "[FileWatcher] inotify is not available, falls back to polling" << std::endl;
+        }
+#endif
+        thread = std::thread(&FileWatcher::run, this);
+    }
+
+    ~FileWatcher() {
+        running = false;
+        thread.join();
+#ifdef __linux__
+        if (inotifyFd >= 0) {
+            close(inotifyFd);
+        }
+#endif
+    }
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    [[nodiscard]]
+    const char* backendName() const {
+        return inotifyFd >= 0 ? "inotify" : "polling";
+    }
+
+    // replaces whatever was watched before. Files that do not exist (yet) are reported once they appear.
+    void watchOnly(const std::vector<std::string>& paths) {
+        std::lock_guard<std::mutex> lock(mutex);
+        unwatchAll();
+        for (const auto& path : paths) {
+            if (path.empty()) {
+                continue;
+            }
+
+            const auto absolute = std::filesystem::absolute(path);
+            const auto parent = absolute.parent_path();
+            auto directory = std::find_if(directories.begin(), directories.end(),
+                                          [&parent](const Directory& d) { return d.path == parent; });
+            if (directory == directories.end()) {
+                directories.push_back({.path = parent});
+                directory = std::prev(directories.end());
+#ifdef __linux__
+                if (inotifyFd >= 0) {
+                    directory->descriptor = inotify_add_watch(
+                        inotifyFd,
+                        parent.c_str(),
+                        IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE
+                    );
+                    if (directory->descriptor < 0) {
+                        std::cout << "[FileWatcher] cannot watch " << parent.string()
+                                  << ", polls its files instead" << std::endl;
+                    }
+                }
+#endif
+            }
+            directory->files[absolute.filename().string()] = path;
+            if (directory->descriptor < 0) {
+                modifiedAt[path] = modificationOf(path);
+            }
+        }
+    }
+
+    // the files that changed (and then stayed as they are for a moment) since the last call, as given to watch
+    std::vector<std::string> takeChanges() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> result(ready.begin(), ready.end());
+        ready.clear();
+        return result;
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_FILEWATCHER_H
@@ -11,6 +11,13 @@
 #include <GL/gl.h>
 #endif
 
+#include <cstddef>
+#include <cstdint>
+#include <format>
+
+using LedIndex = uint16_t;
+// <-- WLED addresses up to 65535 LEDs (DNRGB start index is 16 bit), only WARLS is limited to 8 bit.
+constexpr size_t MAX_LEDS = static_cast<size_t>(UINT16_MAX) + 1;
 
 struct LED {
 
@@ -34,7 +41,8 @@ public:
         return r == other.r && g == other.g && b == other.b;
     }
 
-    static LED from(const std::vector<int>& array, size_t fromIndex = 0) {
+    template <typename Array>
+    static LED from(const Array& array, size_t fromIndex = 0) {
         return LED(array[fromIndex],
                    array[fromIndex + 1],
                    array[fromIndex + 2]);
@@ -52,6 +60,12 @@ public:
         b = w;
     }
 
+    // how the GPU gets it, one RGBA8 word (alpha unused), cf. ShaderState::packedLeds
+    [[nodiscard]]
+    GLuint packed() const {
+        return (r & 0xff) | (g & 0xff) << 8 | (b & 0xff) << 16;
+    }
+
     [[nodiscard]]
     GLuint gray() const {
         auto w = 0.299 * r + 0.587 * g + 0.114 * b;
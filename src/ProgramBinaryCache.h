@@ -0,0 +1,255 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_PROGRAMBINARYCACHE_H
+#define DLTROPHY_SIMULATOR_PROGRAMBINARYCACHE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/gl.h>
+#include "glHelpers.h"
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (GLAD_API_PTR *GetProgramBinaryFunction)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                                      GLenum* binaryFormat, void* binary);
+typedef void (GLAD_API_PTR *ProgramBinaryFunction)(GLuint program, GLenum binaryFormat,
+                                                   const void* binary, GLsizei length);
+typedef void (GLAD_API_PTR *ProgramParameteriFunction)(GLuint program, GLenum pname, GLint value);
+
+struct ProgramBuildStats {
+    std::optional<double> startupMillis;
+    bool startupFromCache = false;
+    std::optional<double> lastColdMillis;
+    // <-- compiled and linked
+    std::optional<double> lastWarmMillis;
+    // <-- taken from the cache
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+class ProgramBinaryCache {
+    /*
+     *  Linked programs as the driver hands them out (glGetProgramBinary(), GL 4.1 or ARB_get_program_binary),
+     *  one file per program in the user's cache directory, so that the next start, F8 or reload of the same
+     *  sources skips compiling and linking. The key hashes the sources as they go into glShaderSource()
+     *  together with the renderer and driver version, as a binary is only good for exactly that driver.
+     *  A binary the driver does not take anymore is just deleted, then it is compiled as usual.
+     */
+
+private:
+    static constexpr char magic[4] = {'D', 'L', 'P', 'B'};
+
+    GetProgramBinaryFunction getProgramBinary = nullptr;
+    ProgramBinaryFunction programBinary = nullptr;
+    ProgramParameteriFunction programParameteri = nullptr;
+    std::filesystem::path directory;
+    std::string driver;
+
+    ProgramBuildStats stats_{};
+
+    static std::filesystem::path userCacheDirectory() {
+#ifdef _WIN32
+        if (const char* localAppData = std::getenv("LOCALAPPDATA")) {
+            return std::filesystem::path(localAppData);
+        }
+#elif defined(__APPLE__)
+        if (const char* home = std::getenv("HOME")) {
+            return std::filesystem::path(home) / "Library" / "Caches";
+        }
+#else
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            return std::filesystem::path(xdg);
+        }
+        if (const char* home = std::getenv("HOME")) {
+            return std::filesystem::path(home) / ".cache";
+        }
+#endif
+        return std::filesystem::temp_directory_path();
+    }
+
+    static std::string glString(GLenum name) {
+        const auto* value = reinterpret_cast<const char*>(glGetString(name));
+        return value ? value : "";
+    }
+
+    // FNV-1a, 64 bit -- nothing is kept secret here, it only must not mix up two programs.
+    static void hash(uint64_t& h, const std::string& text) {
+        for (const unsigned char c : text) {
+            h = (h ^ c) * 0x100000001b3ull;
+        }
+        h = (h ^ 0xff) * 0x100000001b3ull;
+        // <-- so that "ab" + "c" is not "a" + "bc"
+    }
+
+    [[nodiscard]]
+    std::filesystem::path pathOf(const std::string& key) const {
+        return directory / (key + ".bin");
+    }
+
+    void forgetBroken(const std::string& key) const {
+        std::error_code ignored;
+        std::filesystem::remove(pathOf(key), ignored);
+    }
+
+public:
+    explicit ProgramBinaryCache(GLADloadfunc load) {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major * 10 + minor < 41 && !hasExtension("GL_ARB_get_program_binary")) {
+            std::cout << "[Program Cache] not supported by this driver, programs are always compiled" << std::endl;
+            return;
+        }
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats <= 0) {
+            std::cout << "[Program Cache] the driver offers no binary format, programs are always compiled"
+                      << std::endl;
+            return;
+        }
+        getProgramBinary = reinterpret_cast<GetProgramBinaryFunction>(load("glGetProgramBinary"));
+        programBinary = reinterpret_cast<ProgramBinaryFunction>(load("glProgramBinary"));
+        programParameteri = reinterpret_cast<ProgramParameteriFunction>(load("glProgramParameteri"));
+        driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+        directory = userCacheDirectory() / "dltrophy-simulator" / "programs";
+    }
+
+    ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+    ProgramBinaryCache& operator=(const ProgramBinaryCache&) = delete;
+
+    [[nodiscard]]
+    bool works() const {
+        return getProgramBinary && programBinary && programParameteri;
+    }
+
+    [[nodiscard]]
+    const std::filesystem::path& path() const { return directory; }
+
+    [[nodiscard]]
+    const ProgramBuildStats& stats() const { return stats_; }
+
+    [[nodiscard]]
+    std::string keyFor(const std::string& vertexSource, const std::string& fragmentSource) const {
+        uint64_t h = 0xcbf29ce484222325ull;
+        hash(h, driver);
+        hash(h, vertexSource);
+        hash(h, fragmentSource);
+        return std::format("{:016x}", h);
+    }
+
+    // a linked program, or nothing if there is none (or the driver rejects it)
+    std::optional<GLuint> load(const std::string& key) {
+        if (!works()) {
+            return std::nullopt;
+        }
+        std::ifstream file(pathOf(key), std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+        char header[sizeof(magic)];
+        uint32_t format = 0;
+        uint32_t length = 0;
+        file.read(header, sizeof(header));
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        std::vector<char> binary(length);
+        file.read(binary.data(), length);
+        if (!file || std::string_view(header, sizeof(header)) != std::string_view(magic, sizeof(magic))) {
+            forgetBroken(key);
+            return std::nullopt;
+        }
+
+        const GLuint program = glCreateProgram();
+        programBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            // e.g. after a driver update that kept its version string
+            glDeleteProgram(program);
+            forgetBroken(key);
+            return std::nullopt;
+        }
+        return program;
+    }
+
+    // before glLinkProgram(), otherwise the driver might not keep the binary around
+    void prepare(GLuint program) const {
+        if (works()) {
+            programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
+
+    void store(GLuint program, const std::string& key) const {
+        if (!works()) {
+            return;
+        }
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        getProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        // written aside and then renamed, so that a second instance never reads half of it
+        auto written = pathOf(key);
+        auto temporary = written;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            const auto format32 = static_cast<uint32_t>(format);
+            const auto length32 = static_cast<uint32_t>(length);
+            file.write(magic, sizeof(magic));
+            file.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+            file.write(reinterpret_cast<const char*>(&length32), sizeof(length32));
+            file.write(binary.data(), length);
+            if (!file) {
+                std::cout << "[Program Cache] cannot write " << temporary.string() << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, written, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
+    void record(double millis, bool fromCache) {
+        if (!stats_.startupMillis.has_value()) {
+            stats_.startupMillis = millis;
+            stats_.startupFromCache = fromCache;
+        }
+        if (fromCache) {
+            stats_.lastWarmMillis = millis;
+            stats_.hits++;
+        } else {
+            stats_.lastColdMillis = millis;
+            stats_.misses++;
+        }
+    }
+
+    // the next build of every program is cold again
+    void clear() const {
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_PROGRAMBINARYCACHE_H
@@ -0,0 +1,282 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_PROGRAMBUILDER_H
+#define DLTROPHY_SIMULATOR_PROGRAMBUILDER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+#include "glHelpers.h"
+#include "ProgramBinaryCache.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (GLAD_API_PTR *MaxShaderCompilerThreadsFunction)(GLuint count);
+
+struct ProgramBuild {
+    ShaderMeta vertex{GL_VERTEX_SHADER};
+    ShaderMeta fragment{GL_FRAGMENT_SHADER};
+    ProgramMeta program{};
+    double millis = 0;
+    bool fromCache = false;
+    size_t generation = 0;
+};
+
+class ProgramBuilder {
+    /*
+     *  Builds programs for the hot reload without stalling the render loop, the old program goes on until
+     *  poll() hands out the new one (which the TrophyShader then swaps in between two frames).
+     *  With KHR_parallel_shader_compile, the driver compiles in its own threads and poll() only asks whether
+     *  it is done. Otherwise, a worker thread builds on a hidden context that shares its objects with the
+     *  window's, and if there is none of that either, start() simply blocks as it used to.
+     *
+     *  Only the latest start() counts, whatever was still building before is thrown away.
+     */
+
+public:
+    enum class Mode {
+        Blocking,
+        ParallelCompile,
+        SharedContext,
+    };
+
+private:
+    Mode mode_ = Mode::Blocking;
+    ProgramBinaryCache& cache;
+    size_t generation = 0;
+
+    // ParallelCompile: the one the driver works on, started at
+    std::optional<ProgramBuild> inFlight;
+    std::chrono::steady_clock::time_point inFlightSince;
+
+    // SharedContext: handed over under the mutex
+    GLFWwindow* workerContext = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::optional<ProgramBuild> job;
+    bool stopping = false;
+
+    std::optional<ProgramBuild> done;
+    // <-- Blocking and SharedContext, the main thread takes it from here
+
+    static double millisSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static void submit(ProgramBuild& build, const ProgramBinaryCache& cache) {
+        build.vertex.submit();
+        build.fragment.submit();
+        build.program.id = glCreateProgram();
+        glAttachShader(build.program, build.vertex);
+        glAttachShader(build.program, build.fragment);
+        cache.prepare(build.program);
+        glLinkProgram(build.program);
+    }
+
+    static void check(ProgramBuild& build, const ProgramBinaryCache& cache, const std::string& key) {
+        build.vertex.check();
+        build.fragment.check();
+        GLint success;
+        glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+        if (!success) {
+            GLint length = 0;
+            glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &length);
+            build.program.error.assign(std::max(length, 1), '\0');
+            glGetProgramInfoLog(build.program, length, nullptr, &build.program.error[0]);
+            build.program.error.resize(std::strlen(build.program.error.c_str()));
+            if (build.program.error.empty()) {
+                build.program.error = "(the driver gave no reason)";
+            }
+            glDeleteProgram(build.program);
+        }
+        else if (build.vertex.error.empty() && build.fragment.error.empty()) {
+            cache.store(build.program, key);
+        }
+        glDeleteShader(build.vertex);
+        glDeleteShader(build.fragment);
+    }
+
+    void discard(std::optional<ProgramBuild>& build) {
+        if (build && build->program.works()) {
+            glDeleteProgram(build->program);
+        }
+        build.reset();
+    }
+
+    // unlike the others, the one the driver still works on has not been through check(), i.e. has its shaders
+    void discardInFlight() {
+        if (inFlight) {
+            glDeleteShader(inFlight->vertex);
+            glDeleteShader(inFlight->fragment);
+        }
+        discard(inFlight);
+    }
+
+    void runWorker() {
+        glfwMakeContextCurrent(workerContext);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeUp.wait(lock, [this] { return stopping || job.has_value(); });
+            if (stopping) {
+                break;
+            }
+            auto build = std::move(*job);
+            job.reset();
+            lock.unlock();
+
+            link(build, cache);
+            glFinish();
+            // <-- the program must be complete before the other context may use it
+
+            lock.lock();
+            if (build.generation == generation) {
+                discard(done);
+                done = std::move(build);
+            } else if (build.program.works()) {
+                glDeleteProgram(build.program);
+            }
+        }
+        glfwMakeContextCurrent(nullptr);
+    }
+
+public:
+    // compileContext: a hidden window sharing with the main one, or nullptr
+    ProgramBuilder(ProgramBinaryCache& cache, GLFWwindow* compileContext)
+    : cache(cache) {
+        const bool parallel = hasExtension("GL_KHR_parallel_shader_compile");
+        if (parallel || hasExtension("GL_ARB_parallel_shader_compile")) {
+            auto maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFunction>(
+                glfwGetProcAddress(parallel ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB")
+            );
+            if (maxThreads) {
+                maxThreads(0xFFFFFFFF);
+                // <-- as many as the driver likes
+                mode_ = Mode::ParallelCompile;
+            }
+        }
+        if (mode_ == Mode::Blocking && compileContext) {
+            workerContext = compileContext;
+            mode_ = Mode::SharedContext;
+            worker = std::thread(&ProgramBuilder::runWorker, this);
+        }
+        std::cout << "[Program Builder] reloads are built " << modeName() << std::endl;
+    }
+
+    ~ProgramBuilder() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wakeUp.notify_one();
+            worker.join();
+        }
+        discardInFlight();
+        discard(done);
+    }
+
+    ProgramBuilder(const ProgramBuilder&) = delete;
+    ProgramBuilder& operator=(const ProgramBuilder&) = delete;
+
+    [[nodiscard]]
+    Mode mode() const { return mode_; }
+
+    [[nodiscard]]
+    const char* modeName() const {
+        switch (mode_) {
+            case Mode::ParallelCompile:
+                return "by the driver in parallel";
+            case Mode::SharedContext:
+                return "on a worker thread";
+            default:
+                return "blocking";
+        }
+    }
+
+    // right here, from the cache if possible. Fills in build.program, the errors and the time.
+    static void link(ProgramBuild& build, ProgramBinaryCache& cache) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto key = cache.keyFor(build.vertex.source, build.fragment.source);
+        if (auto cached = cache.load(key)) {
+            build.vertex.error = "";
+            build.fragment.error = "";
+            build.program.id = *cached;
+            build.fromCache = true;
+        } else {
+            submit(build, cache);
+            check(build, cache, key);
+            build.fromCache = false;
+        }
+        build.millis = millisSince(start);
+    }
+
+    void start(const ShaderMeta& vertex, const ShaderMeta& fragment) {
+        ProgramBuild build{.vertex = vertex, .fragment = fragment};
+        switch (mode_) {
+            case Mode::ParallelCompile: {
+                discardInFlight();
+                build.generation = ++generation;
+                inFlightSince = std::chrono::steady_clock::now();
+                const auto key = cache.keyFor(build.vertex.source, build.fragment.source);
+                if (auto cached = cache.load(key)) {
+                    build.program.id = *cached;
+                    build.fromCache = true;
+                    build.millis = millisSince(inFlightSince);
+                    discard(done);
+                    done = std::move(build);
+                    return;
+                }
+                submit(build, cache);
+                inFlight = std::move(build);
+                return;
+            }
+            case Mode::SharedContext: {
+                std::lock_guard<std::mutex> lock(mutex);
+                build.generation = ++generation;
+                discard(done);
+                job = std::move(build);
+                wakeUp.notify_one();
+                return;
+            }
+            default:
+                build.generation = ++generation;
+                link(build, cache);
+                discard(done);
+                done = std::move(build);
+                return;
+        }
+    }
+
+    // the latest build, once it is done (with or without errors). Never waits.
+    std::optional<ProgramBuild> poll() {
+        if (mode_ == Mode::ParallelCompile && inFlight) {
+            GLint completed = GL_FALSE;
+            glGetProgramiv(inFlight->program, GL_COMPLETION_STATUS_KHR, &completed);
+            if (!completed) {
+                return std::nullopt;
+            }
+            const auto key = cache.keyFor(inFlight->vertex.source, inFlight->fragment.source);
+            check(*inFlight, cache, key);
+            inFlight->millis = millisSince(inFlightSince);
+            done = std::move(inFlight);
+            inFlight.reset();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        auto result = std::move(done);
+        done.reset();
+        return result;
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_PROGRAMBUILDER_H
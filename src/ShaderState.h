@@ -5,6 +5,7 @@
 #ifndef DLTROPHY_SIMULATOR_SHADERSTATE_H
 #define DLTROPHY_SIMULATOR_SHADERSTATE_H
 
+#include <algorithm>
 #include <cstdint>
 #include <array>
 #include <span>
@@ -25,8 +26,8 @@ enum Shader {
 };
 
 struct ShaderOptions {
-    // this needs minimum alignment (GLint = 4 bytes), therefore a multiple of 4 of flags.
-    // (well, at the end of the std140 layout this could even deviate, but don't rely on that.)
+    // these are not uploaded, but compiled into the fragment shader as #defines (one program per combination,
+    // cf. TrophyShader::fragmentVariant()). The order is the one of TrophyShader::optionDefines.
     bool showGrid;
     bool accumulateForever;
     bool noStochasticVariation;
@@ -67,6 +68,8 @@ struct ShaderState {
     Trophy* trophy;
     GLuint nLeds;
     std::vector<LED> leds;
+    std::vector<GLuint> packedLeds;
+    // <-- the same colors as the GPU reads them, one RGBA8 texel of the ledColors texture buffer per LED
 
     Parameters params {
         .ledSize = 0.015,
@@ -126,11 +129,16 @@ struct ShaderState {
 
     bool verbose = false;
 
+    size_t dirtyFrom = 0;
+    size_t dirtyTo = 0;
+    // <-- the LEDs [from, to) changed since the renderer took them last, cf. takeDirtyLeds()
+
     explicit ShaderState(Trophy* trophy):
         trophy(trophy),
         nLeds(trophy->position.size())
         {
             leds.resize(nLeds);
+            packedLeds.resize(nLeds);
             for (int i = 0; i < nLeds; i++) {
                 leds[i] = LED();
             }
@@ -142,27 +150,42 @@ struct ShaderState {
             };
         };
 
-    GLsizei alignedTotalSize(Shader mode) {
-        GLsizei baseSize = alignedSizeForLeds();
+    GLsizei alignedSizeForParameters(Shader mode) {
         switch (mode) {
             case Shader::TrophyView:
-                return baseSize
-                       + sizeof(params)
-                       + sizeof(options);
+                return sizeof(params);
             case Shader::LogoDevel:
                 // vec4 -> size and center of the 2D logo (... just why, again?)
-                return baseSize
-                        + sizeof(glm::vec4)
+                return sizeof(glm::vec4)
                         + sizeof(logoDevelOptions);
             default:
-                return baseSize;
+                return 0;
         }
     }
 
-    GLsizei alignedSizeForLeds() {
-        return static_cast<GLsizei>(leds.size()) * sizeof(leds[0]);
+    GLsizei sizeForLeds() {
+        return static_cast<GLsizei>(packedLeds.size()) * sizeof(packedLeds[0]);
     }
 
+    void markDirty(size_t from, size_t to) {
+        if (dirtyTo <= dirtyFrom) {
+            dirtyFrom = from;
+            dirtyTo = to;
+            return;
+        }
+        dirtyFrom = std::min(dirtyFrom, from);
+        dirtyTo = std::max(dirtyTo, to);
+    }
+
+    // the LEDs [first, second) that changed since the last call, in leds and packedLeds alike
+    std::pair<size_t, size_t> takeDirtyLeds() {
+        auto range = std::make_pair(dirtyFrom, dirtyTo);
+        dirtyFrom = 0;
+        dirtyTo = 0;
+        return range;
+    }
+
+    // takes any size_t and checks it here, a LedIndex parameter would wrap larger ones before that
     void set(size_t index, LED led, bool silent = false) {
         if (index >= nLeds) {
             if (silent) {
@@ -172,33 +195,47 @@ struct ShaderState {
                     std::format("Trophy has no LED at index {0}", index)
             );
         }
-        if (trophy->isSingleColor[index]) {
-            leds[index].set(led.gray());
-        } else {
-            leds[index].set(led);
+        const auto shown = trophy->isSingleColor[index]
+            ? LED(led.gray())
+            : led;
+        if (leds[index] == shown) {
+            return;
         }
+        leds[index].set(shown);
+        packedLeds[index] = shown.packed();
+        markDirty(index, index + 1);
     }
 
     void set(size_t index, GLuint r = 0, GLuint g = 0, GLuint b = 0) {
         set(index, LED(r, g, b));
     }
 
-    void setFrom(std::unordered_map<uint8_t, LED> mapping) {
-        for (const auto& [index, led] : mapping) {
-            set(index, led);
+    void setFrom(std::span<const LED> source) {
+        // only what really changed is marked, a sender repeating the same frame costs no upload
+        const auto count = std::min(source.size(), leds.size());
+        size_t first = count;
+        size_t last = 0;
+        for (size_t index = 0; index < count; index++) {
+            const auto shown = trophy->isSingleColor[index]
+                ? LED(source[index].gray())
+                : source[index];
+            if (leds[index] == shown) {
+                continue;
+            }
+            leds[index].set(shown);
+            packedLeds[index] = shown.packed();
+            first = std::min(first, index);
+            last = index + 1;
         }
-    }
-
-    void setFrom(std::vector<LED> mapping) {
-        for (size_t i = 0; i < mapping.size(); i++) {
-            set(i, mapping[i]);
+        if (first < last) {
+            markDirty(first, last);
         }
     }
 
     // The following functions are here for debugging / development
 
     void set(std::function<LED(size_t)> func) {
-        for (int i = 0; i < nLeds; i++) {
+        for (size_t i = 0; i < nLeds; i++) {
             auto led = func(i);
             set(i, led);
         }
@@ -212,7 +249,7 @@ struct ShaderState {
     }
 
     void randomize() {
-        for (int i = 0; i < nLeds; i++) {
+        for (size_t i = 0; i < nLeds; i++) {
             uint8_t r = std::rand() % 256;
             uint8_t g = std::rand() % 256;
             uint8_t b = std::rand() % 256;
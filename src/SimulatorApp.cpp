@@ -2,8 +2,14 @@
 // Created by qm210 on 10.05.2025.
 //
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
 #include <stdexcept>
 #include <iostream>
+#include <string>
+#include <thread>
 #include <variant>
 
 #include "SimulatorApp.h"
@@ -40,10 +46,20 @@ SimulatorApp::SimulatorApp(Config config)
     state = new ShaderState(trophy);
     config.restore(state);
 
-    shader = new TrophyShader(config, state);
+    programBuilder = new ProgramBuilder(TrophyShader::programCache(), compileContext);
+    shader = new TrophyShader(config, state, programBuilder);
     shader->assertSuccess(showError);
+    fileWatcher = new FileWatcher();
+    watchFiles();
 
-    udpListener = new UdpListener(config.udpPort);
+    if (!config.recordPath.empty()) {
+        try {
+            capture = std::make_shared<CaptureWriter>(config.recordPath);
+        } catch (const std::exception& e) {
+            std::cerr << "[Capture] " << e.what() << std::endl;
+        }
+    }
+    udpIngest = new UdpIngest(ingestSettings());
 
     // WIP: for measuring the FPS drops (goes to 1-2... then resizing the window solves the problem)
     // monitor = new PerformanceMonitor("perf.measure");
@@ -54,10 +70,18 @@ SimulatorApp::SimulatorApp(Config config)
 }
 
 SimulatorApp::~SimulatorApp() {
+    liveview.reset();
+    delete udpIngest;
+    delete fileWatcher;
+    delete programBuilder;
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    if (compileContext) {
+        glfwDestroyWindow(compileContext);
+    }
     if (window) {
         glfwDestroyWindow(window);
     }
@@ -91,6 +115,11 @@ GLFWwindow* SimulatorApp::initializeWindow() {
 
     config.restore(window);
 
+    // shares its objects with the window, so that shaders can be built on another thread (cf. ProgramBuilder)
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    compileContext = glfwCreateWindow(1, 1, "", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
     glfwMakeContextCurrent(window);
 
     glfwSetWindowUserPointer(window, this);
@@ -141,10 +170,12 @@ void SimulatorApp::run() {
         shader->iFPS.set(averageFps);
         shader->iMouse.set();
         shader->render();
+        glState().endFrame();
 
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
+        measureDrawLatency();
 
         if (prototyper->service()) {
             state->setFrom(prototyper->buildLeds());
@@ -155,12 +186,175 @@ void SimulatorApp::run() {
 
         // monitor-> ... // TODO
 
-        shader->mightHotReload(config);
+        handleChangedFiles();
     }
 
     config.store(window);
 }
 
+void SimulatorApp::watchFiles() {
+    auto files = shader->watchedFiles();
+    files.push_back(config.path.string());
+    fileWatcher->watchOnly(files);
+}
+
+void SimulatorApp::handleChangedFiles() {
+    // everything that was saved (and then left alone for a moment) since the last frame
+    const auto changedFiles = fileWatcher->takeChanges();
+    const bool configChanged =
+        std::find(changedFiles.begin(), changedFiles.end(), config.path.string()) != changedFiles.end();
+    if (configChanged && config.reread(state)) {
+        std::cout << "[Config] took over the changes in " << config.path.string() << std::endl;
+        shader->updateLedPositions();
+    }
+    shader->mightHotReload(config, changedFiles);
+}
+
+void SimulatorApp::runBenchmark() {
+    // the same scene with more and more LEDs, each frame with new random colors, so everything is uploaded.
+    // no vsync and glFinish() per frame, so it is what the GPU takes, not what the display allows.
+    glfwSwapInterval(0);
+    constexpr std::array<size_t, 3> fixtures = {Trophy::N_LEDS, 1000, 5000};
+    constexpr std::array<const char*, 3> uploads = {"persistent", "orphaning", "subdata"};
+    std::cout << "[Benchmark] " << config.benchmarkFrames << " frames per fixture, upload and post pass at "
+              << area.width << "x" << area.height << std::endl;
+
+    for (const auto nLeds : fixtures) {
+        Trophy fixture(nLeds);
+        ShaderState fixtureState(&fixture);
+        fixtureState.params = state->params;
+        fixtureState.options = state->options;
+        TrophyShader fixtureShader(config, &fixtureState);
+        if (!fixtureShader.assertSuccess(showError)) {
+            return;
+        }
+
+        // every uniform upload path, and each once with the POST_PASS tracing the scene again (as it used to),
+        // once with its own program
+        for (const auto* upload : uploads) {
+            fixtureShader.useUniformUpload(upload);
+            for (const bool dedicatedPost : {false, true}) {
+                fixtureShader.dedicatedPostPass = dedicatedPost;
+                fixtureShader.resetUploadStats();
+                LatencyHistogram frameTime;
+                std::chrono::nanoseconds total{0};
+                int frame = 0;
+                for (; frame < config.benchmarkFrames && !glfwWindowShouldClose(window); frame++) {
+                    glfwPollEvents();
+                    fixtureState.randomize();
+
+                    const auto start = std::chrono::steady_clock::now();
+                    fixtureShader.use();
+                    fixtureShader.iTime.set(static_cast<float>(frame) / 60.f);
+                    fixtureShader.iFrame.set(frame);
+                    fixtureShader.render();
+                    glFinish();
+                    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+                    frameTime.record(elapsed);
+                    total += elapsed;
+                    glfwSwapBuffers(window);
+                }
+                if (frame == 0) {
+                    return;
+                }
+                const auto summary = frameTime.summary();
+                const auto uploadSummary = fixtureShader.uploadStats();
+                std::cout << std::format("[Benchmark] {:5} LEDs, upload {:10}, post {:9}: "
+                                         "avg. {:8.3f} ms / frame ({:7.1f} fps), "
+                                         "p50 {:8.3f} / p99 {:8.3f} / max {:8.3f} ms, upload p50 {:6.3f} ms CPU",
+                                         nLeds,
+                                         fixtureShader.uniformUploadName(),
+                                         dedicatedPost ? "dedicated" : "retraced",
+                                         std::chrono::duration<double, std::milli>(total).count() / frame,
+                                         frame / std::chrono::duration<double>(total).count(),
+                                         summary.p50Millis,
+                                         summary.p99Millis,
+                                         summary.maxMillis,
+                                         uploadSummary.p50Millis)
+                          << std::endl;
+            }
+        }
+    }
+
+    runReceiveBenchmark();
+}
+
+void SimulatorApp::runReceiveBenchmark() {
+    // both receive backends, one after the other, with the same DRGB stream at 1k, 10k and 100k packets/s.
+    // Sent to ourselves over the loopback, so this is what the receive thread costs, not the network.
+    constexpr std::array<int, 3> rates = {1000, 10000, 100000};
+    constexpr auto measured = std::chrono::seconds(2);
+    // <-- the ingest updates its stats once a second, so the second one is all at the rate
+
+    delete udpIngest;
+    udpIngest = nullptr;
+    // <-- it has the port
+
+    auto settings = ingestSettings();
+    settings.capture = nullptr;
+    settings.replayPath = "";
+    settings.sharedFrames = "";
+
+    const MinimalSocket::Address target("127.0.0.1", static_cast<MinimalSocket::Port>(settings.udpPort));
+    MinimalSocket::udp::Udp<true> sender(MinimalSocket::ANY_PORT, MinimalSocket::AddressFamily::IP_V4);
+    if (!sender.open()) {
+        std::cerr << "[Benchmark] Cannot open a socket to send from, no receive benchmark" << std::endl;
+    } else {
+        std::string packet(2 + 3 * std::min<size_t>(settings.nLeds, 489), '\0');
+        // <-- DRGB, as far as one packet goes
+        packet[0] = 2;
+        packet[1] = 1;
+
+        for (const auto* backend : {"socket", "io_uring"}) {
+            settings.backend = backend;
+            UdpIngest ingest(settings);
+            if (std::string(ingest.backendName()) != backend) {
+                std::cout << "[Benchmark] receive via " << backend << ": not available here" << std::endl;
+                continue;
+            }
+            for (const auto rate : rates) {
+                const auto interval = std::chrono::nanoseconds(1'000'000'000 / rate);
+                const auto receivedBefore = ingest.receivedPackages();
+                size_t sent = 0;
+                const auto start = std::chrono::steady_clock::now();
+                // sleep_for() is too coarse for 100k packets/s, so it only sleeps if there is time to spare
+                for (auto next = start; next - start < measured;) {
+                    packet[2] = static_cast<char>(sent);
+                    sender.sendTo(packet, target);
+                    sent++;
+                    next += interval;
+                    for (auto now = std::chrono::steady_clock::now(); now < next;
+                         now = std::chrono::steady_clock::now()) {
+                        if (next - now > std::chrono::milliseconds(2)) {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        }
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                // <-- whatever is still in the socket
+                const auto stats = ingest.stats();
+                std::cout << std::format("[Benchmark] receive via {:8} at {:6} packets/s: "
+                                         "{:9.0f} packets/s, {:6.2f} us CPU / packet, {} of {} received",
+                                         backend,
+                                         rate,
+                                         stats.packetsPerSecond,
+                                         stats.cpuMicrosPerPacket,
+                                         ingest.receivedPackages() - receivedBefore,
+                                         sent)
+                          << std::endl;
+            }
+        }
+    }
+
+    try {
+        udpIngest = new UdpIngest(ingestSettings());
+    } catch (const std::exception& e) {
+        // the kernel might not have let go of the io_uring's socket yet, handleMessages() would try again
+        std::cerr << "[Benchmark] " << e.what() << std::endl;
+    }
+}
+
 void SimulatorApp::handleTime() {
     currentFrame++;
     previousTime = currentTime;
@@ -227,10 +421,11 @@ void SimulatorApp::initializeKeyMap() {
         GLFW_KEY_F8,
         [this](int mods) {
             toggle(config.useLogoDevelShader);
-            auto newShader = new TrophyShader(config, state);
+            auto newShader = new TrophyShader(config, state, programBuilder);
             if (newShader->assertSuccess(showError)) {
                 delete shader;
                 shader = newShader;
+                watchFiles();
             }
         }
     }, {
@@ -301,32 +496,92 @@ void SimulatorApp::handleMouseInput() {
 }
 
 void SimulatorApp::handleMessages() {
-    if (!udpListener->runsOn(config.udpPort)) {
-        delete udpListener;
-        udpListener = new UdpListener(config.udpPort);
+    if (!udpIngest || !udpIngest->runsWith(ingestSettings())) {
+        delete udpIngest;
+        udpIngest = new UdpIngest(ingestSettings());
+        playout.reset();
+        shownSource.reset();
+        // <-- the liveview stays connected, updateLiveview() only starts over if the LED count changed
     }
-    auto udpPacket = udpListener->listen();
+    udpIngest->verbose = state->verbose;
+    updateLiveview();
 
-    if (!udpPacket.has_value()) {
+    if (!takeFrame()) {
         return;
     }
 
-    auto message = UdpInterpreter::interpret(*udpPacket);
+    state->setFrom(udpFrame.leds);
+    undrawnFrameDecodedAt = udpFrame.decodedAt;
+    if (udpFrame.lastMessage.has_value()) {
+        lastUdpMessage = udpFrame.lastMessage;
+    }
+}
 
-    std::visit([this](auto&& msg) {
-        using T = std::decay_t<decltype(msg)>;
+void SimulatorApp::measureDrawLatency() {
+    // the swap is where we can tell anything about it being drawn, the vsync wait counts as well
+    if (!undrawnFrameDecodedAt) {
+        return;
+    }
+    decodeToDraw.record(std::chrono::steady_clock::now() - *undrawnFrameDecodedAt);
+    undrawnFrameDecodedAt.reset();
+}
 
-        if constexpr (std::is_same_v<T, ProtocolMessage>) {
-            state->setFrom(msg.mapping);
-            this->lastUdpMessage = msg;
+void SimulatorApp::updateLiveview() {
+    if (config.liveview.empty()) {
+        liveview.reset();
+        showLiveview = false;
+        return;
+    }
+    const auto nLeds = ingestSettings().nLeds;
+    if (liveview && liveview->isRunningUnder(config.liveview, nLeds)) {
+        return;
+    }
+    // as many LEDs as the ingest has, so that the frames can swap their buffers with each other
+    liveview = std::make_unique<WebSocketListener>(config.liveview, nLeds);
+}
 
-        } else if constexpr (std::is_same_v<T, UnreadableMessage>) {
-            if (this->state->verbose) {
-                msg.printDebug(std::cout);
-            }
-        }
+bool SimulatorApp::takeFrame() {
+    // the liveview comes at its own (low) pace, without any frame assembly, so it passes by the playout
+    if (showLiveview) {
+        udpIngest->discardFrames();
+        return liveview->takeLatest(udpFrame);
+    }
+    if (liveview && !shownSource && liveview->takeLatest(udpFrame)) {
+        return true;
+    }
+    if (!config.playout.enabled) {
+        playout.reset();
+        return udpIngest->takeLatest(udpFrame, shownSource);
+    }
+    if (!playout) {
+        playout.emplace(config.playout);
+    }
+    playout->update(config.playout);
+    while (udpIngest->takeNext(udpFrame, shownSource)) {
+        playout->push(udpFrame);
+    }
+    return playout->release(std::chrono::steady_clock::now(), udpFrame);
+}
 
-    }, message);
+IngestSettings SimulatorApp::ingestSettings() const {
+    return {
+        .udpPort = config.udpPort,
+        .nLeds = config.udpLedCount > 0
+            ? std::clamp<size_t>(config.udpLedCount, state->nLeds, MAX_LEDS)
+            : state->nLeds,
+        // <-- before it becomes a size_t, where -1 would be all the LEDs there can be
+        .backend = config.udpBackend,
+        .dmx = config.dmx,
+        .ddpPort = config.ddpPort,
+        .capture = capture,
+        .replayPath = config.replayPath,
+        .replaySpeed = config.replaySpeed,
+        .frameCommit = config.udpFrameCommit,
+        .frameGapMs = config.udpFrameGapMs,
+        .extraPorts = config.udpExtraPorts,
+        .separateSenders = config.udpSeparateSenders,
+        .sharedFrames = config.sharedFrames,
+    };
 }
 
 void SimulatorApp::handleResize() {
@@ -393,6 +648,24 @@ void SimulatorApp::buildControlPanel() {
         ImGui::Spacing();
     }
 
+    const auto& programBuilds = TrophyShader::programCache().stats();
+    auto millisOrDash = [](const std::optional<double>& millis) {
+        return millis.has_value() ? std::format("{:.0f} ms", *millis) : std::string("-");
+    };
+    ImGui::Text("Program: startup %s (%s), last cold %s, last warm %s, %zu hits / %zu misses",
+                millisOrDash(programBuilds.startupMillis).c_str(),
+                programBuilds.startupFromCache ? "warm" : "cold",
+                millisOrDash(programBuilds.lastColdMillis).c_str(),
+                millisOrDash(programBuilds.lastWarmMillis).c_str(),
+                programBuilds.hits,
+                programBuilds.misses);
+    if (TrophyShader::programCache().works()) {
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Clear##ProgramCache")) {
+            TrophyShader::programCache().clear();
+        }
+    }
+
     auto stop = 0.24f * panelWidth;
     ImGui::Text("Time:");
     ImGui::SameLine(stop);
@@ -424,6 +697,203 @@ void SimulatorApp::buildControlPanel() {
                     0, 0,
                     ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_CharsDecimal);
 
+    auto ingestStats = udpIngest->stats();
+    ImGui::Text("UDP In:");
+    ImGui::SameLine(stop);
+    if (ingestStats.cpuMicrosPerPacket < 0) {
+        ImGui::Text("%8.0f pkt/s (%s)",
+                    ingestStats.packetsPerSecond,
+                    udpIngest->backendName());
+    } else {
+        ImGui::Text("%8.0f pkt/s, %6.2f us CPU/pkt (%s)",
+                    ingestStats.packetsPerSecond,
+                    ingestStats.cpuMicrosPerPacket,
+                    udpIngest->backendName());
+    }
+    if (auto sharedStats = udpIngest->sharedStats()) {
+        ImGui::Text("Shared:");
+        ImGui::SameLine(stop);
+        if (sharedStats->attached) {
+            ImGui::Text("%zu frames from %s, %zu skipped, %zu torn",
+                        sharedStats->frames,
+                        config.sharedFrames.c_str(),
+                        sharedStats->skippedFrames,
+                        sharedStats->tornFrames);
+        } else {
+            ImGui::Text("waiting for %s", config.sharedFrames.c_str());
+        }
+    }
+    if (liveview) {
+        auto liveviewStats = liveview->stats();
+        ImGui::Text("Liveview:");
+        ImGui::SameLine(stop);
+        ImGui::Text("%s (%s), %zu frames of %d x %d, %zu not drawn, %zu unreadable",
+                    liveview->endpoint().c_str(),
+                    liveview->stateName(),
+                    liveviewStats.frames,
+                    liveviewStats.width,
+                    liveviewStats.height,
+                    liveviewStats.overwritten,
+                    liveviewStats.unreadable);
+    }
+    if (auto nSources = udpIngest->sourceCount(); nSources > 0 || liveview) {
+        ImGui::Text("Sources:");
+        ImGui::SameLine(stop);
+        const auto shownName = showLiveview
+            ? std::string("liveview")
+            : shownSource
+            ? udpIngest->sourceStats(*shownSource).name()
+            : std::string("whoever sent last");
+        ImGui::PushItemWidth(0.3f * panelWidth);
+        if (ImGui::BeginCombo("##ShownSource", shownName.c_str())) {
+            auto choose = [this](std::optional<size_t> source, bool chooseLiveview = false) {
+                if (source != shownSource || chooseLiveview != showLiveview) {
+                    shownSource = source;
+                    showLiveview = chooseLiveview;
+                    playout.reset();
+                    // <-- another sender has another pace
+                }
+            };
+            if (ImGui::Selectable("whoever sent last", !shownSource && !showLiveview)) {
+                choose(std::nullopt);
+            }
+            for (size_t s = 0; s < nSources; s++) {
+                auto name = std::format("{}##Source{}", udpIngest->sourceStats(s).name(), s);
+                if (ImGui::Selectable(name.c_str(), shownSource == s)) {
+                    choose(s);
+                }
+            }
+            if (liveview && ImGui::Selectable("liveview", showLiveview)) {
+                choose(std::nullopt, true);
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::PopItemWidth();
+        for (size_t s = 0; s < nSources; s++) {
+            auto sourceStats = udpIngest->sourceStats(s);
+            ImGui::Text("");
+            ImGui::SameLine(stop);
+            ImGui::Text("%-21s %6.0f pkt/s, %zu frames, %s %.1f s ago (%zu dropouts)",
+                        sourceStats.name().c_str(),
+                        sourceStats.packetsPerSecond,
+                        sourceStats.frames,
+                        sourceStats.stale ? "STALE, last" : "last",
+                        sourceStats.silentSeconds,
+                        sourceStats.dropouts);
+        }
+        if (auto rejected = udpIngest->rejectedPackets(); rejected > 0) {
+            ImGui::Text("");
+            ImGui::SameLine(stop);
+            ImGui::Text("%zu packets from further senders ignored", rejected);
+        }
+        if (auto truncated = udpIngest->truncatedPackets(); truncated > 0) {
+            ImGui::Text("");
+            ImGui::SameLine(stop);
+            ImGui::Text("%zu packets ignored, larger than a WLED packet can be", truncated);
+        }
+        if (auto dropped = udpIngest->droppedFrames(); dropped > 0) {
+            ImGui::Text("");
+            ImGui::SameLine(stop);
+            ImGui::Text("%zu frames dropped, the render loop did not take them in time", dropped);
+        }
+    }
+    ImGui::Text("Playout:");
+    ImGui::SameLine(stop);
+    ImGui::Checkbox("##PlayoutEnabled", &config.playout.enabled);
+    if (playout) {
+        auto playoutStats = playout->stats();
+        ImGui::SameLine();
+        ImGui::Text("%5.1f ms delay (every %5.1f ms +- %4.1f), %zu late, %zu dropped",
+                    playoutStats.delayMillis,
+                    playoutStats.cadenceMillis,
+                    playoutStats.jitterMillis,
+                    playoutStats.late,
+                    playoutStats.dropped);
+        ImGui::Text("");
+        ImGui::SameLine(stop);
+        ImGui::PushItemWidth(0.2f * panelWidth);
+        ImGui::SliderFloat("##PlayoutSmoothness", &config.playout.smoothness, 0.f, 1.f, "smoothness %.2f");
+        ImGui::SameLine();
+        ImGui::DragIntRange2("ms##PlayoutDelay", &config.playout.minDelayMs, &config.playout.maxDelayMs,
+                             1.f, 0, 250, "min %d", "max %d");
+        ImGui::PopItemWidth();
+    }
+    if (auto frameStats = udpIngest->frameStats(); frameStats.frames > 0) {
+        ImGui::Text("Frames:");
+        ImGui::SameLine(stop);
+        ImGui::Text("%zu assembled (\"%s\"), %zu of them by a %d ms gap",
+                    frameStats.frames,
+                    config.udpFrameCommit.c_str(),
+                    frameStats.byGap,
+                    config.udpFrameGapMs);
+    }
+    if (capture) {
+        ImGui::Text("Recording:");
+        ImGui::SameLine(stop);
+        ImGui::Text("%zu packets to %s",
+                    capture->packets(),
+                    capture->filename().c_str());
+    }
+    if (!config.replayPath.empty()) {
+        ImGui::Text("Replay:");
+        ImGui::SameLine(stop);
+        if (config.replaySpeed > 0) {
+            ImGui::Text("%s at %.2fx%s",
+                        config.replayPath.c_str(),
+                        config.replaySpeed,
+                        udpIngest->replayFinished() ? " - done" : "");
+        } else {
+            ImGui::Text("%s as fast as possible%s",
+                        config.replayPath.c_str(),
+                        udpIngest->replayFinished() ? " - done" : "");
+        }
+    }
+    if (ingestStats.arrivalInterval.count > 0) {
+        ImGui::Text("Arrival:");
+        ImGui::SameLine(stop);
+        ImGui::Text("p50 %7.3f / p99 %7.3f / max %7.3f ms apart",
+                    ingestStats.arrivalInterval.p50Millis,
+                    ingestStats.arrivalInterval.p99Millis,
+                    ingestStats.arrivalInterval.maxMillis);
+        ImGui::Text("Ingest:");
+        ImGui::SameLine(stop);
+        ImGui::Text("p50 %7.3f / p99 %7.3f / max %7.3f ms to decode",
+                    ingestStats.receiveToDecode.p50Millis,
+                    ingestStats.receiveToDecode.p99Millis,
+                    ingestStats.receiveToDecode.maxMillis);
+    }
+    if (auto drawStats = decodeToDraw.summary(); drawStats.count > 0) {
+        ImGui::Text("Render:");
+        ImGui::SameLine(stop);
+        ImGui::Text("p50 %7.3f / p99 %7.3f / max %7.3f ms to draw",
+                    drawStats.p50Millis,
+                    drawStats.p99Millis,
+                    drawStats.maxMillis);
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Reset##Latencies")) {
+            udpIngest->resetLatencies();
+            decodeToDraw.reset();
+        }
+    }
+    if (auto ddpStats = udpIngest->ddpStats(); ddpStats && ddpStats->frames > 0) {
+        ImGui::Text("DDP In:");
+        ImGui::SameLine(stop);
+        ImGui::Text("%zu frames, %zu missing segments, %zu late / %zu missing pushes",
+                    ddpStats->frames,
+                    ddpStats->missingSegments,
+                    ddpStats->latePushes,
+                    ddpStats->missingPushes);
+    }
+    if (auto dmxStats = udpIngest->dmxStats()) {
+        ImGui::Text("DMX In:");
+        ImGui::SameLine(stop);
+        ImGui::Text("%zu frames (%zu incomplete, %zu synced), %zu late",
+                    dmxStats->frames,
+                    dmxStats->incompleteFrames,
+                    dmxStats->syncedFrames,
+                    dmxStats->lateUniverses);
+    }
+
     ImGuiHelper::JustifiedButtons({
         {"Randomize LEDs", [this]() {
             state->randomize();
@@ -587,6 +1057,37 @@ void SimulatorApp::buildControlPanel() {
                         &state->options.noStochasticVariation);
         ImGui::Checkbox("Only Pyramid Frame",
                         &state->options.onlyPyramidFrame);
+
+        ImGui::PushItemWidth(0.24f * panelWidth);
+        if (ImGui::BeginCombo("##UniformUpload", shader->uniformUploadName())) {
+            for (const auto* mode : {"persistent", "orphaning", "subdata"}) {
+                if (ImGui::Selectable(mode, config.uniformUpload == mode)) {
+                    config.uniformUpload = mode;
+                    shader->useUniformUpload(config.uniformUpload);
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::PopItemWidth();
+        auto uploadStats = shader->uploadStats();
+        ImGui::SameLine();
+        ImGui::Text("Upload: %6zu bytes (avg. %8.1f / frame), p50 %6.3f / p99 %6.3f ms CPU, %zu waits",
+                    shader->lastUploadedBytes(),
+                    shader->averageUploadedBytes(),
+                    uploadStats.p50Millis,
+                    uploadStats.p99Millis,
+                    shader->uploadFenceWaits());
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Reset##Upload")) {
+            shader->resetUploadStats();
+        }
+        ImGui::Checkbox("Skip redundant GL calls", &glState().enabled);
+        ImGui::SameLine();
+        const auto glCalls = glState().lastFrame();
+        ImGui::Text("GL calls: %3zu issued, %3zu skipped / frame", glCalls.issued, glCalls.skipped);
+        ImGui::Checkbox("Dedicated post pass", &shader->dedicatedPostPass);
+        ImGui::SameLine();
+        ImGui::TextDisabled("(off: traces the scene twice per frame, only to compare)");
     }
 
     ImGui::PopItemWidth();
@@ -609,20 +1110,100 @@ void SimulatorApp::printDebug() const {
     }
     std::cout << std::endl;
 
-    std::cout << "[UdpListener] # Packages Received: " << udpListener->receivedPackages() << std::endl;
+    std::cout << "[UdpListener] # Packages Received: " << udpIngest->receivedPackages()
+              << " (# Frames skipped by the render loop: " << udpIngest->skippedFrames()
+              << ", dropped on a full ring: " << udpIngest->droppedFrames() << ")" << std::endl;
+    auto ingestStats = udpIngest->stats();
+    std::cout << "[UdpListener] Backend: " << udpIngest->backendName()
+              << ", " << ingestStats.packetsPerSecond << " packets/s, "
+              << ingestStats.cpuMicrosPerPacket << " us CPU/packet" << std::endl;
+    for (size_t s = 0; s < udpIngest->sourceCount(); s++) {
+        auto sourceStats = udpIngest->sourceStats(s);
+        std::cout << "[UdpListener] Source #" << s << (shownSource == s ? " (shown)" : "") << ": "
+                  << sourceStats.name() << ", " << sourceStats.packets << " packets, "
+                  << sourceStats.frames << " frames, " << sourceStats.packetsPerSecond << " packets/s, last one "
+                  << sourceStats.silentSeconds << " s ago" << (sourceStats.stale ? " (stale)" : "") << ", "
+                  << sourceStats.dropouts << " dropouts" << std::endl;
+    }
+    if (auto sharedStats = udpIngest->sharedStats()) {
+        std::cout << "[Shared] " << config.sharedFrames << (sharedStats->attached ? "" : " (waiting for it)") << ": "
+                  << sharedStats->frames << " frames, " << sharedStats->skippedFrames << " skipped, "
+                  << sharedStats->tornFrames << " torn" << std::endl;
+    }
+    if (liveview) {
+        auto liveviewStats = liveview->stats();
+        std::cout << "[Liveview] " << liveview->endpoint() << " (" << liveview->stateName()
+                  << (showLiveview ? ", shown" : "") << "): " << liveviewStats.frames << " frames of "
+                  << liveviewStats.width << " x " << liveviewStats.height << ", "
+                  << liveviewStats.overwritten << " not drawn, " << liveviewStats.unreadable << " unreadable"
+                  << std::endl;
+    }
+    auto frameStats = udpIngest->frameStats();
+    std::cout << "[UdpListener] " << frameStats.frames << " frames assembled (rule \"" << config.udpFrameCommit
+              << "\"), " << frameStats.byGap << " of them by the gap of " << config.udpFrameGapMs << " ms" << std::endl;
+    if (playout) {
+        auto playoutStats = playout->stats();
+        std::cout << "[Playout] " << playoutStats.delayMillis << " ms delay, sender every "
+                  << playoutStats.cadenceMillis << " ms +- " << playoutStats.jitterMillis << " ms, "
+                  << playoutStats.buffered << " buffered, " << playoutStats.released << " released, "
+                  << playoutStats.late << " late, " << playoutStats.dropped << " dropped, waited p50 "
+                  << playoutStats.waited.p50Millis << " ms, p99 " << playoutStats.waited.p99Millis << " ms"
+                  << std::endl;
+    }
+    auto printLatency = [](const char* what, const LatencySummary& latency) {
+        std::cout << "[Latency] " << what << ": p50 " << latency.p50Millis
+                  << " ms, p99 " << latency.p99Millis
+                  << " ms, max " << latency.maxMillis
+                  << " ms (" << latency.count << " samples)" << std::endl;
+    };
+    printLatency("Arrival interval", ingestStats.arrivalInterval);
+    printLatency("Receive to decode", ingestStats.receiveToDecode);
+    printLatency("Decode to draw", decodeToDraw.summary());
+    printLatency(std::format("Uniform upload ({})", shader->uniformUploadName()).c_str(), shader->uploadStats());
+    std::cout << "[Upload] " << shader->averageUploadedBytes() << " bytes per frame on average" << std::endl;
+    const auto& programBuilds = TrophyShader::programCache().stats();
+    std::cout << "[Program Builder] reloads are built " << programBuilder->modeName() << std::endl;
+    std::cout << "[File Watcher] shaders and config are watched via " << fileWatcher->backendName() << std::endl;
+    std::cout << "[Program Cache] " << TrophyShader::programCache().path().string() << ": "
+              << programBuilds.hits << " hits, " << programBuilds.misses << " misses, startup "
+              << programBuilds.startupMillis.value_or(0) << " ms ("
+              << (programBuilds.startupFromCache ? "warm" : "cold") << ")" << std::endl;
+    std::cout << "[GL State] " << glState().lastFrame().issued << " calls issued, "
+              << glState().lastFrame().skipped << " skipped in the last frame"
+              << (glState().enabled ? "" : " (skipping is off)") << std::endl;
+    if (auto ddpStats = udpIngest->ddpStats()) {
+        std::cout << "[DDP] " << ddpStats->frames << " frames, "
+                  << ddpStats->missingSegments << " missing segments, "
+                  << ddpStats->latePushes << " late pushes, "
+                  << ddpStats->missingPushes << " missing pushes, "
+                  << ddpStats->ignoredPackets << " ignored packets" << std::endl;
+    }
+    if (auto dmxStats = udpIngest->dmxStats()) {
+        std::cout << "[DMX] " << dmxStats->frames << " frames, "
+                  << dmxStats->incompleteFrames << " incomplete, "
+                  << dmxStats->syncedFrames << " synced, "
+                  << dmxStats->lateUniverses << " late universes, "
+                  << dmxStats->unmappedUniverses << " unmapped universes" << std::endl;
+    }
 
     if (!lastUdpMessage) {
         std::cout << "[UdpListener] got no interpretable Message so far." << std::endl;
         return;
     }
 
-    std::cout << "[UdpListener] last Message (size" << lastUdpMessage->mapping.size() << ") from "
+    std::cout << "[UdpListener] last Message (" << lastUdpMessage->ledCount << " LEDs, index "
+              << lastUdpMessage->firstIndex << ".." << lastUdpMessage->lastIndex
+              << ", " << lastUdpMessage->ignoredLeds << " ignored) from "
               << formatTime(lastUdpMessage->timestamp) << std::endl;
-    for (auto const& [index, led]: lastUdpMessage->mapping) {
-        std::cout << "    Index " << std::setw(3) << static_cast<int>(index)
-                  << ": " << led.toString() << std::endl;
+    if (lastUdpMessage->ledCount > 0) {
+        // (the receiver might take more LEDs than the trophy has, these are not printed)
+        const size_t lastIndex = std::min<size_t>(lastUdpMessage->lastIndex, state->nLeds - 1);
+        for (size_t index = lastUdpMessage->firstIndex; index <= lastIndex; index++) {
+            std::cout << "    Index " << std::setw(3) << index
+                      << ": " << state->leds[index].toString() << std::endl;
+        }
     }
-    std::cout << "    Source: " << lastUdpMessage->source << std::endl;
+    std::cout << "    Source: " << lastUdpMessage->source.toString() << std::endl;
 
     std::cout << " === iRect  = " << shader->iRect.to_string() << std::endl;
     std::cout << " === iMouse = " << shader->iMouse.to_string() << std::endl;
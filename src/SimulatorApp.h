@@ -15,8 +15,10 @@
 #include "TrophyShader.h"
 #include "Config.h"
 #include "inputHelpers.h"
-#include "UdpListener.h"
-#include "UdpInterpreter.h"
+#include "UdpIngest.h"
+#include "WebSocketListener.h"
+#include "LatencyHistogram.h"
+#include "FileWatcher.h"
 #include "prototyper/Prototyper.h" // <-- WIP
 #include "PerformanceMonitor.h" // <-- not finished
 
@@ -28,6 +30,8 @@ public:
     ~SimulatorApp();
 
     void run();
+    void runBenchmark();
+    void runReceiveBenchmark();
 
     void printDebug() const;
 
@@ -51,6 +55,11 @@ private:
     void handleMouseInput();
 
     TrophyShader* shader;
+    GLFWwindow* compileContext = nullptr;
+    ProgramBuilder* programBuilder = nullptr;
+    FileWatcher* fileWatcher = nullptr;
+    void watchFiles();
+    void handleChangedFiles();
 
     float startTimestamp = 0;
     float latestTimestamp = 0;
@@ -69,9 +78,24 @@ private:
     Trophy* trophy;
     ShaderState* state;
 
-    UdpListener* udpListener;
+    std::shared_ptr<CaptureWriter> capture;
+    UdpIngest* udpIngest;
+    LedFrame udpFrame;
+    std::optional<PlayoutBuffer> playout;
+    std::optional<size_t> shownSource;
+    // <-- which sender is drawn (cf. UdpIngest::sourceStats()), none means whoever sent last
+    std::unique_ptr<WebSocketListener> liveview;
+    bool showLiveview = false;
+    // <-- then only the liveview is drawn, and what the UdpIngest gets is thrown away
+    void updateLiveview();
+    bool takeFrame();
     std::optional<ProtocolMessage> lastUdpMessage;
     void handleMessages();
+    [[nodiscard]] IngestSettings ingestSettings() const;
+    LatencyHistogram decodeToDraw;
+    std::optional<std::chrono::steady_clock::time_point> undrawnFrameDecodedAt;
+    // <-- the frame taken from the ingest is drawn in the next loop, measured after its buffer swap
+    void measureDrawLatency();
 
     Prototyper* prototyper;
 
@@ -5,8 +5,10 @@
 #ifndef DLTROPHY_SIMULATOR_TROPHY_H
 #define DLTROPHY_SIMULATOR_TROPHY_H
 
+#include <algorithm>
 #include <cstddef>
 #include <array>
+#include <vector>
 #include <functional>
 #include <cmath>
 #include <iostream>
@@ -30,11 +32,12 @@ struct Trophy {
     static constexpr int backLedIndex = N_LEDS - 2;
     static constexpr int floorLedIndex = N_LEDS - 1;
 
-    std::array<glm::vec4, N_LEDS> position{};
+    std::vector<glm::vec4> position;
+    // <-- the w component is unused, it just makes a texel of the RGBA32F texture buffer
 
-    std::array<bool, N_LEDS> isSingleColor{};
-    std::array<bool, N_LEDS> isLogo{};
-    std::array<bool, N_LEDS> isBase{};
+    std::vector<bool> isSingleColor;
+    std::vector<bool> isLogo;
+    std::vector<bool> isBase;
 
     glm::vec3 logoCenter = {-.025f, 0.26f, 0.f};
     glm::vec2 logoSize = {0.75f, 0.35f};
@@ -45,18 +48,27 @@ struct Trophy {
 
     glm::vec3 posMin{}, posMax{};
 
-    Trophy() {
+    // more than N_LEDS is a larger fixture, for benchmarking: the extra LEDs are RGB, spread around the trophy
+    explicit Trophy(size_t nLeds = N_LEDS)
+    : position(std::max<size_t>(nLeds, N_LEDS)),
+      isSingleColor(position.size()),
+      isLogo(position.size()),
+      isBase(position.size())
+    {
         rebuild();
     }
 
+    [[nodiscard]]
+    size_t count() const { return position.size(); }
+
     void rebuild() {
         posMin = {0, 0, 0};
         posMax = {0, 0, 0};
 
-        for (int i = 0; i < N_LEDS; i++) {
+        for (int i = 0; i < count(); i++) {
             isBase[i] = i >= baseStartIndex && i < baseStartIndex + N_LEDS_IN_BASE;
             isLogo[i] = i >= logoStartIndex && i < logoStartIndex + N_LEDS_IN_LOGO;
-            isSingleColor[i] = !isLogo[i] && !isBase[i];
+            isSingleColor[i] = i == backLedIndex || i == floorLedIndex;
 
             glm::vec2 relative;
             glm::vec3 absolute;
@@ -77,6 +89,9 @@ struct Trophy {
                         logoCenter.z
                 };
             }
+            else if (i >= N_LEDS) {
+                absolute = calc_extra_position(i - N_LEDS, count() - N_LEDS);
+            }
             else {
                 if (i == floorLedIndex) {
                     absolute = floorLedPos;
@@ -162,26 +177,29 @@ struct Trophy {
         return from + delta * step_in_edge;
     }
 
-    size_t alignedTotalSize() {
-        return alignedSizeOfNumber() + alignedSizeOfPositions();
+    glm::vec3 calc_extra_position(size_t extra_index, size_t n_extra) const {
+        // a Fibonacci sphere around the logo, evenly spread for any number
+        constexpr float goldenAngle = 2.39996323f;
+        constexpr float radius = 0.5f;
+        const float y = 1.f - 2.f * (static_cast<float>(extra_index) + 0.5f) / static_cast<float>(n_extra);
+        const float r = std::sqrt(1.f - y * y);
+        const float phi = goldenAngle * static_cast<float>(extra_index);
+        return {
+            logoCenter.x + radius * r * std::cos(phi),
+            logoCenter.y + radius * y,
+            logoCenter.z + radius * r * std::sin(phi)
+        };
     }
 
-    size_t alignedSizeOfNumber() {
-        // first element is N_LEDS as uint -> 4 bytes -> too small.
-        // from then on, the offset of an array must be a multiple of its base data size
-        return sizeof(position[0]);
-    }
-    
-    size_t alignedSizeOfPositions() {
-        // position is now vec4 to match the alignment
+    size_t sizeOfPositions() const {
         return position.size() * sizeof(position[0]);
     }
 
     void printDebug() {
-        auto nLength = std::to_string(N_LEDS).length();
-        std::cout << "=== DEBUG TROPHY LED POSITIONS === N = " << N_LEDS << std::endl;
+        auto nLength = std::to_string(count()).length();
+        std::cout << "=== DEBUG TROPHY LED POSITIONS === N = " << count() << std::endl;
 
-        for (int i = 0; i < N_LEDS; i++) {
+        for (int i = 0; i < count(); i++) {
 
             if (i == logoStartIndex) {
                 std::cout << "  LOGO:" << std::endl;
@@ -189,6 +207,8 @@ struct Trophy {
                 std::cout << "  BASE:" << std::endl;
             } else if (i == N_RGB_LEDS) {
                 std::cout << "  WHITE-ONLY:" << std::endl;
+            } else if (i == N_LEDS) {
+                std::cout << "  EXTRA:" << std::endl;
             }
 
             auto p = position[i];
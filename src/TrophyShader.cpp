@@ -2,25 +2,38 @@
 // Created by qm210 on 10.05.2025.
 //
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <format>
 #include "TrophyShader.h"
 #include "glHelpers.h"
+#include <GLFW/glfw3.h>
 
 #ifdef USE_EMBEDDED_SHADERS
 #include "shaders/embedded.h"
 #else
 const std::string default_vertex_shader_path = "./shaders/vertex.glsl";
 const std::string default_fragment_shader_path = "./shaders/fragment.glsl";
+const std::string default_post_shader_path = "./shaders/post.glsl";
+const std::string default_common_shader_path = "./shaders/common.glsl";
 #endif
 
 
-TrophyShader::TrophyShader(Config& config, ShaderState *state)
-: state(state) {
+TrophyShader::TrophyShader(Config& config, ShaderState *state, ProgramBuilder* builder)
+: state(state),
+  builder(builder) {
+    bufferStorage = loadBufferStorage(glfwGetProcAddress);
+    uniformUpload = StreamingBuffer::modeFrom(config.uniformUpload);
     bool fragmentOk = loadShaderSources(config);
     if (!fragmentOk) {
         // might get generalized, but for now, this is the only distinction.
         config.useLogoDevelShader = false;
     }
+    currentMode = config.useLogoDevelShader
+            ? Shader::LogoDevel
+            : Shader::TrophyView;
     program = createProgram();
     initializeProgram(config);
 }
@@ -43,6 +56,14 @@ bool TrophyShader::loadShaderSources(const Config& config) {
 #endif
     }
 
+#ifdef USE_EMBEDDED_SHADERS
+    post.takeEmbedded(embedded_post_shader);
+    common.takeEmbedded(embedded_common_shader);
+#else
+    post.read(default_post_shader_path);
+    common.read(default_common_shader_path);
+#endif
+
     logoDevelModeError = "";
     if (config.useLogoDevelShader) {
         try {
@@ -76,11 +97,19 @@ void TrophyShader::initializeProgram(const Config& config) {
     if (!glIsProgram(program)) {
         std::cerr << "[Shader Program] is not valid, error is \"" << program.error << "\"" << std::endl;
     };
-    currentMode = config.useLogoDevelShader
-            ? Shader::LogoDevel
-            : Shader::TrophyView;
 
+    createPostProgram();
     glUseProgram(program);
+    bindProgramInterface();
+    initUniformBuffers();
+
+    onRectChange(config.windowSize, config);
+    glState().forget();
+}
+
+void TrophyShader::bindProgramInterface() {
+    // everything that belongs to the program object itself, i.e. to be done again for a reloaded one.
+    // it must be in use.
     iRect.loadLocation(program);
     iTime.loadLocation(program);
     iFPS.loadLocation(program);
@@ -89,23 +118,46 @@ void TrophyShader::initializeProgram(const Config& config) {
     iPreviousImage.loadLocation(program);
     iBloomImage.loadLocation(program);
     iMouse.loadLocation(program);
+    nLeds.loadLocation(program);
+    ledPositions.loadLocation(program);
+    ledColors.loadLocation(program);
+    pyramidRotation.loadLocation(program);
+    camRotation.loadLocation(program);
+    lightDir.loadLocation(program);
+    floorColor.loadLocation(program);
+
+    nLeds.set(static_cast<int>(state->nLeds));
+    ledPositions.set(ledPositionsUnit);
+    ledColors.set(ledColorsUnit);
+    iPreviousImage.set(0);
+    iBloomImage.set(1);
 
-    initUniformBuffers();
-
-    onRectChange(config.windowSize, config);
+    // the buffer itself is bound anew whenever it changes, cf. render()
+    GLuint blockIndex = glGetUniformBlockIndex(program,
+                                               currentMode == Shader::LogoDevel
+                                               ? "LogoStateBuffer"
+                                               : "StateBuffer"
+                                               );
+    glUniformBlockBinding(program, blockIndex, stateBindingPoint);
 }
 
 void TrophyShader::teardown() {
-    if (program.works()) {
-        glDeleteProgram(program);
+    forgetVariants();
+    if (postProgram.works()) {
+        glDeleteProgram(postProgram);
     }
     glDeleteVertexArrays(1, &vertexArrayObject);
     glDeleteBuffers(1, &vertexBufferObject);
-    glDeleteBuffers(1, &stateBufferId);
-    glDeleteBuffers(1, &definitionBufferId);
+    ledBuffer.teardown();
+    stateBuffer.teardown();
+    glDeleteTextures(1, &positionTextureId);
+    glDeleteBuffers(1, &positionBufferId);
+    positionTextureId = 0;
+    positionBufferId = 0;
     feedbackFramebuffers.teardown();
     ledsOnly.teardown();
     glDeleteTextures(2, &extraOutputTexture[0]);
+    glState().forget();
 }
 
 void TrophyShader::onRectChange(Size resolution, const Config& config) {
@@ -122,45 +174,127 @@ void TrophyShader::onRectChange(Size resolution, const Config& config) {
 
     extraOutputs.initialize(rect);
     glViewport(rect.x, rect.y, rect.width, rect.height);
+    glState().forget();
 }
 
 void TrophyShader::reload(const Config& config) {
     vertex.read();
     fragment.read();
+    if (!common.usesEmbedded()) {
+        common.read();
+    }
 
     lastReload = std::chrono::system_clock::to_time_t(
             std::chrono::system_clock::now()
     );
 
-    auto newProgram = createProgram();
-    auto totalError = collectErrorLogs(newProgram);
-    reloadFailed = !totalError.empty();
-    if (reloadFailed) {
-        std::cerr << totalError << std::endl;
+    reloadVariant = variantOf(state->options);
+    if (builder) {
+        // the current program goes on until the new one is done, cf. takeReloadedProgram()
+        builder->start(vertex, fragmentVariant(reloadVariant));
+        reloadPending = true;
         return;
     }
+    ProgramBuild build{.vertex = vertex, .fragment = fragmentVariant(reloadVariant)};
+    ProgramBuilder::link(build, programCache());
+    adoptProgram(std::move(build));
+}
 
-    teardown();
-    program = newProgram;
-    initializeProgram(config);
+bool TrophyShader::takeReloadedProgram() {
+    if (!builder || !reloadPending) {
+        return false;
+    }
+    auto build = builder->poll();
+    if (!build) {
+        return false;
+    }
+    reloadPending = false;
+    adoptProgram(std::move(*build));
+    return true;
+}
+
+static std::string validationErrorOf(GLuint program) {
+    glValidateProgram(program);
+    GLint valid = GL_FALSE;
+    glGetProgramiv(program, GL_VALIDATE_STATUS, &valid);
+    if (valid) {
+        return "";
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    std::string log(std::max(length, 1), '\0');
+    glGetProgramInfoLog(program, length, nullptr, &log[0]);
+    return "Shader Validation Error:\n" + std::string(log.c_str()) + "\n";
+}
+
+void TrophyShader::adoptProgram(ProgramBuild build) {
+    // between two frames: the new program gets the same locations, samplers and block binding as the old one,
+    // and is validated against the state the last frame was rendered with, before the old one is given up.
+    programCache().record(build.millis, build.fromCache);
+    vertex.error = build.vertex.error;
+    fragment.error = build.fragment.error;
+    reloadError = collectErrorLogs(build.program);
+
+    if (reloadError.empty()) {
+        const auto previous = program;
+        program = build.program;
+        glState().forget();
+        glUseProgram(program);
+        bindProgramInterface();
+        reloadError = validationErrorOf(program);
+        if (!reloadError.empty()) {
+            program = previous;
+            glUseProgram(program);
+            bindProgramInterface();
+            glDeleteProgram(build.program);
+        } else {
+            // the other variants are of the old sources, they are built again when asked for
+            forgetVariants();
+            currentVariant = reloadVariant;
+            variants[currentVariant] = program;
+        }
+    }
+    reloadFailed = !reloadError.empty();
+    if (reloadFailed) {
+        std::cerr << reloadError << std::endl;
+        return;
+    }
+    std::cout << "[Shader Program] reloaded in " << build.millis << " ms"
+              << (build.fromCache ? " (from the cache)" : "") << std::endl;
 }
 
-void TrophyShader::mightHotReload(const Config &config) {
+void TrophyShader::mightHotReload(const Config &config, const std::vector<std::string>& changedFiles) {
+    takeReloadedProgram();
     if (!config.hotReloadShaders) {
         return;
     }
-    auto vertexShaderChanged = vertex.fileHasChanged();
-    auto fragmentShaderChanged = fragment.fileHasChanged();
+    auto changed = [&changedFiles](const ShaderMeta& shader) {
+        return !shader.usesEmbedded()
+            && std::find(changedFiles.begin(), changedFiles.end(), shader.filePath) != changedFiles.end();
+    };
+    auto vertexShaderChanged = changed(vertex);
+    auto fragmentShaderChanged = changed(fragment);
+    auto postShaderChanged = changed(post);
+    auto commonShaderChanged = changed(common);
+    if (postShaderChanged) {
+        post.read();
+        std::cout << "Hot Reload: -- Post Shader: " << post.filePath << std::endl;
+    }
+    if (commonShaderChanged) {
+        std::cout << "Hot Reload: -- Common Shader: " << common.filePath << std::endl;
+    }
+    if (vertexShaderChanged || fragmentShaderChanged || commonShaderChanged) {
+        reload(config);
+        // <-- reads common.glsl again, too
+    }
+    if (vertexShaderChanged || postShaderChanged || commonShaderChanged) {
+        createPostProgram();
+    }
     if (!vertexShaderChanged && !fragmentShaderChanged) {
         return;
     }
 
-    reload(config);
-    auto info = lastReloadInfo();
-    std::cout << "Hot Reload: " << info.first;
-    if (!info.second.empty()) {
-        std::cout << " -- " << info.second;
-    }
+    std::cout << "Hot Reload:";
     if (!fragmentShaderChanged) {
         std::cout << " -- Vertex Shader: " << vertex.filePath;
     }
@@ -173,25 +307,157 @@ void TrophyShader::mightHotReload(const Config &config) {
     std::cout << std::endl;
 }
 
+std::vector<std::string> TrophyShader::watchedFiles() const {
+    std::vector<std::string> result;
+    for (const auto* shader : {&vertex, &fragment, &post, &common}) {
+        if (!shader->usesEmbedded()) {
+            result.push_back(shader->filePath);
+        }
+    }
+    return result;
+}
+
+ProgramBinaryCache& TrophyShader::programCache() {
+    // needs the GL context, so not before the first program
+    static ProgramBinaryCache cache(glfwGetProcAddress);
+    return cache;
+}
+
 ProgramMeta TrophyShader::createProgram() {
-    vertex.compile();
-    fragment.compile();
+    // the very first one, nothing could be rendered before it anyway
+    currentVariant = variantOf(state->options);
+    ProgramBuild build{.vertex = vertex, .fragment = fragmentVariant(currentVariant)};
+    ProgramBuilder::link(build, programCache());
+    programCache().record(build.millis, build.fromCache);
+    vertex.error = build.vertex.error;
+    fragment.error = build.fragment.error;
+    if (build.program.works()) {
+        variants[currentVariant] = build.program;
+    }
+    return build.program;
+}
+
+void TrophyShader::createPostProgram() {
+    // small enough to be built right away, also on a hot reload. If it fails, the POST_PASS traces again.
+    if (postProgram.works()) {
+        glDeleteProgram(postProgram);
+    }
+    postProgram = {};
+    if (currentMode != Shader::TrophyView) {
+        return;
+    }
+    ProgramBuild build{.vertex = vertex, .fragment = withCommon(post)};
+    ProgramBuilder::link(build, programCache());
+    postProgram = build.program;
+    if (!postProgram.works()) {
+        std::cerr << "[Post Program] cannot be built, the scene is traced again instead:\n"
+                  << build.vertex.error << build.fragment.error << build.program.error << std::endl;
+        return;
+    }
+    glUseProgram(postProgram);
+    postRect.loadLocation(postProgram);
+    postAccumulatedImage.loadLocation(postProgram);
+    postBloomImage.loadLocation(postProgram);
+    postAccumulatedImage.set(0);
+    postBloomImage.set(1);
+    GLuint blockIndex = glGetUniformBlockIndex(postProgram, "StateBuffer");
+    glUniformBlockBinding(postProgram, blockIndex, stateBindingPoint);
+    glState().forget();
+}
 
-    ProgramMeta prog;
-    prog.id = glCreateProgram();
-    glAttachShader(prog, vertex);
-    glAttachShader(prog, fragment);
-    glLinkProgram(prog);
-    GLint success;
-    glGetProgramiv(prog, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(prog, 512, nullptr, &prog.error[0]);
-        glDeleteProgram(prog);
+unsigned TrophyShader::variantOf(const ShaderOptions& options) const {
+    if (currentMode != Shader::TrophyView) {
+        return 0;
     }
+    const std::array<bool, optionDefines.size()> flags = {
+        options.showGrid, options.accumulateForever, options.noStochasticVariation, options.onlyPyramidFrame
+    };
+    unsigned result = 0;
+    for (size_t i = 0; i < flags.size(); i++) {
+        if (flags[i]) {
+            result |= 1u << i;
+        }
+    }
+    return result;
+}
+
+ShaderMeta TrophyShader::fragmentVariant(unsigned variant) const {
+    // the #defines go right below the #version, and the #line after them keeps the error messages
+    // at the lines of the file. The program cache tells the variants apart by exactly this source.
+    ShaderMeta result = withCommon(fragment);
+    std::string defines;
+    for (size_t i = 0; i < optionDefines.size(); i++) {
+        if (variant & (1u << i)) {
+            defines += std::string("#define ") + optionDefines[i] + "\n";
+        }
+    }
+    if (defines.empty()) {
+        return result;
+    }
+    const auto version = result.source.find("#version");
+    if (version == std::string::npos) {
+        result.source = defines + "#line 1\n" + result.source;
+        return result;
+    }
+    const auto versionEnd = std::min(result.source.find('\n', version), result.source.size());
+    const auto nextLine = std::count(result.source.begin(), result.source.begin() + versionEnd, '\n') + 2;
+    result.source.insert(versionEnd, "\n" + defines + "#line " + std::to_string(nextLine));
+    return result;
+}
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    return prog;
+ShaderMeta TrophyShader::withCommon(ShaderMeta shader) const {
+    // GLSL has no #include, so common.glsl goes right in place of that line. The #line directives keep the
+    // error messages at the lines of either file, with common.glsl counted as source string 1.
+    const std::string directive = "#include \"common.glsl\"";
+    const auto at = shader.source.find(directive);
+    if (at == std::string::npos) {
+        return shader;
+    }
+    const auto nextLine = std::count(shader.source.begin(), shader.source.begin() + at, '\n') + 2;
+    shader.source.replace(at, directive.size(),
+                          "#line 1 1\n" + common.source + "\n#line " + std::to_string(nextLine) + " 0");
+    return shader;
+}
+
+void TrophyShader::selectVariant() {
+    // the options changed (by a checkbox or the config), so take (or build) the program that has them
+    const auto wanted = variantOf(state->options);
+    if (wanted == currentVariant) {
+        return;
+    }
+    auto found = variants.find(wanted);
+    if (found == variants.end()) {
+        ProgramBuild build{.vertex = vertex, .fragment = fragmentVariant(wanted)};
+        ProgramBuilder::link(build, programCache());
+        programCache().record(build.millis, build.fromCache);
+        const auto error = build.vertex.error + build.fragment.error + build.program.error;
+        if (!error.empty() || !build.program.works()) {
+            // stays with what it has, the option just has no effect until the sources are fixed
+            std::cerr << "[Shader Program] cannot build the variant for the options " << wanted << ":\n"
+                      << error << std::endl;
+            state->options = ShaderOptions{
+                .showGrid = (currentVariant & 1u) != 0,
+                .accumulateForever = (currentVariant & 2u) != 0,
+                .noStochasticVariation = (currentVariant & 4u) != 0,
+                .onlyPyramidFrame = (currentVariant & 8u) != 0,
+            };
+            return;
+        }
+        std::cout << "[Shader Program] variant for the options " << wanted << " built in " << build.millis
+                  << " ms" << (build.fromCache ? " (from the cache)" : "") << std::endl;
+        found = variants.emplace(wanted, build.program).first;
+    }
+    currentVariant = wanted;
+    program = found->second;
+    glState().useProgram(program);
+    bindProgramInterface();
+}
+
+void TrophyShader::forgetVariants() {
+    for (const auto& [variant, built] : variants) {
+        glDeleteProgram(built);
+    }
+    variants.clear();
 }
 
 std::string TrophyShader::collectErrorLogs(std::optional<ProgramMeta> otherProgram) const {
@@ -311,64 +577,67 @@ void TrophyShader::initFramebuffers(const Rect& rect) {
 }
 
 void TrophyShader::initUniformBuffers() {
-    // pass LEDs as Uniform Buffers, but separated in
-    // - the Definition (is set once)
-    // - the RGB State (is updated frequently)
-
-    glDeleteBuffers(1, &stateBufferId);
-    glDeleteBuffers(1, &definitionBufferId);
-
-    GLuint bufferId[2];
-    glGenBuffers(2, &bufferId[0]);
-    stateBufferId = bufferId[0];
-    definitionBufferId = bufferId[1];
-
-    GLuint blockIndex;
-    GLuint bindingPoint = 0;
-
-    blockIndex = glGetUniformBlockIndex(program, "TrophyDefinition");
-    glUniformBlockBinding(program, blockIndex, bindingPoint);
-    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, definitionBufferId);
-    glBindBuffer(GL_UNIFORM_BUFFER, definitionBufferId);
-    glBufferData(GL_UNIFORM_BUFFER,
-                 state->trophy->alignedTotalSize(),
+    // the LEDs go as texture buffers, so there can be any number of them (nLeds is a plain uniform):
+    // - the Positions (are set once, cf. updateLedPositions())
+    // - the LED Colors (change with every frame that arrives)
+    // and the Parameters & Options as Uniform Buffer (only change when a slider moves)
+
+    glDeleteTextures(1, &positionTextureId);
+    glDeleteBuffers(1, &positionBufferId);
+    glGenBuffers(1, &positionBufferId);
+    glGenTextures(1, &positionTextureId);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, positionBufferId);
+    glBufferData(GL_TEXTURE_BUFFER,
+                 static_cast<GLsizeiptr>(state->trophy->sizeOfPositions()),
                  nullptr,
                  GL_STATIC_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER,
-                    0,
-                    sizeof(state->nLeds),
-                    &state->nLeds
-    );
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, positionTextureId);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, positionBufferId);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
     updateLedPositions();
 
-    bindingPoint++;
-    blockIndex = glGetUniformBlockIndex(program,
-                                        currentMode == Shader::LogoDevel
-                                        ? "LogoStateBuffer"
-                                        : "StateBuffer"
-                                        );
-    glUniformBlockBinding(program, blockIndex, bindingPoint);
-    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, stateBufferId);
-    glBindBuffer(GL_UNIFORM_BUFFER, stateBufferId);
-    glBufferData(GL_UNIFORM_BUFFER,
-                 state->alignedTotalSize(currentMode),
-                 nullptr,
-                 GL_DYNAMIC_DRAW);
+    initStreamingBuffers();
+}
+
+void TrophyShader::initStreamingBuffers() {
+    ledBuffer.initialize(GL_TEXTURE_BUFFER, state->sizeForLeds(), uniformUpload, bufferStorage, GL_RGBA8);
+    parameterImage.assign(state->alignedSizeForParameters(currentMode), 0);
+    stateBuffer.initialize(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(parameterImage.size()),
+                           uniformUpload, bufferStorage);
+    glState().forget();
+}
+
+void TrophyShader::useUniformUpload(const std::string& mode) {
+    uniformUpload = StreamingBuffer::modeFrom(mode);
+    initStreamingBuffers();
+    resetUploadStats();
+}
 
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+void TrophyShader::resetUploadStats() {
+    uploadTime.reset();
+    uploadedBytesTotal = 0;
+    uploadFrames = 0;
 }
 
 void TrophyShader::updateLedPositions() const {
     // if you changed the public fields of state->trophy,
-    // this will publish the changes into the uniform buffer.
+    // this will publish the changes into the texture buffer.
 
-    glBindBuffer(GL_UNIFORM_BUFFER, definitionBufferId);
-    glBufferSubData(GL_UNIFORM_BUFFER,
-                    state->trophy->alignedSizeOfNumber(),
-                    state->trophy->alignedSizeOfPositions(),
+    glBindBuffer(GL_TEXTURE_BUFFER, positionBufferId);
+    glBufferSubData(GL_TEXTURE_BUFFER,
+                    0,
+                    static_cast<GLsizeiptr>(state->trophy->sizeOfPositions()),
                     state->trophy->position.data()
     );
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TrophyShader::bindLedBuffers() const {
+    glState().bindTexture(ledPositionsUnit, GL_TEXTURE_BUFFER, positionTextureId);
+    ledBuffer.bind(ledColorsUnit);
+    stateBuffer.bind(stateBindingPoint);
 }
 
 void TrophyShader::use() {
@@ -376,50 +645,48 @@ void TrophyShader::use() {
         throw std::runtime_error("Cannot use program, because linking failed.");
     }
 
-    glUseProgram(program);
+    selectVariant();
+    glState().useProgram(program);
 
     iRect.set();
 }
 
-void TrophyShader::fillStateUniformBuffer() {
-    int offset = 0;
+void TrophyShader::fillParameterImage() {
+    size_t offset = 0;
 
-    auto putIntoUniformBuffer = [&](size_t size, const void* data) {
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    auto put = [&](size_t size, const void* data) {
+        std::memcpy(parameterImage.data() + offset, data, size);
         offset += size;
     };
 
-    putIntoUniformBuffer(
-            state->alignedSizeForLeds(),
-            state->leds.data()
-    );
-
     switch (currentMode) {
         case Shader::TrophyView:
-            putIntoUniformBuffer(
-                    sizeof(state->params),
-                    &state->params
-            );
-            putIntoUniformBuffer(
-                    sizeof(state->options),
-                    &state->options
-            );
+            put(sizeof(state->params), &state->params);
             break;
         case Shader::LogoDevel:
-            putIntoUniformBuffer(
-                    sizeof(state->logoGeometry),
-                    &state->logoGeometry
-            );
-            putIntoUniformBuffer(
-                    sizeof(state->logoDevelOptions),
-                    &state->logoDevelOptions
-            );
+            put(sizeof(state->logoGeometry), &state->logoGeometry);
+            put(sizeof(state->logoDevelOptions), &state->logoDevelOptions);
             break;
         default:
             break;
     }
 }
 
+void TrophyShader::uploadState() {
+    constexpr auto ledSize = sizeof(state->packedLeds[0]);
+    const auto [dirtyFrom, dirtyTo] = state->takeDirtyLeds();
+    ledBuffer.markDirty(static_cast<GLintptr>(dirtyFrom * ledSize), static_cast<GLintptr>(dirtyTo * ledSize));
+    uploadedBytes = ledBuffer.upload(reinterpret_cast<const uint8_t*>(state->packedLeds.data()));
+
+    // the sliders write right into the state, so it is just compared with what went up before
+    fillParameterImage();
+    stateBuffer.markDifferences(parameterImage.data());
+    uploadedBytes += stateBuffer.upload(parameterImage.data());
+
+    uploadedBytesTotal += uploadedBytes;
+    uploadFrames++;
+}
+
 static inline void draw() {
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
@@ -429,24 +696,24 @@ const int SCENE_PASS = 1;
 const int POST_PASS = 2;
 
 void TrophyShader::render() {
-    glBindBuffer(GL_UNIFORM_BUFFER, stateBufferId);
-    fillStateUniformBuffer();
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    const auto uploadStart = std::chrono::steady_clock::now();
+    uploadState();
+    uploadTime.record(std::chrono::steady_clock::now() - uploadStart);
+    bindLedBuffers();
+    setFrameConstants();
 
     iPass.set(ONLY_LEDS_PASS);
     iBloomImage.set(1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindFramebuffer(GL_FRAMEBUFFER, ledsOnly.fbo);
-    glBindTexture(GL_TEXTURE_2D, ledsOnly.texture);
+    glState().bindFramebuffer(ledsOnly.fbo);
+    glState().bindTexture(1, GL_TEXTURE_2D, ledsOnly.texture);
     draw();
 
     iPreviousImage.set(0);
     iPass.set(SCENE_PASS);
-    glActiveTexture(GL_TEXTURE0);
     auto order = feedbackFramebuffers.getOrderAndAdvance();
-    glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffers.fbo[order.first]);
-    glDrawBuffers(2, drawBuffers);
-    glBindTexture(GL_TEXTURE_2D, feedbackFramebuffers.texture[order.second]);
+    glState().bindFramebuffer(feedbackFramebuffers.fbo[order.first]);
+    glState().drawBuffers(2, drawBuffers);
+    glState().bindTexture(0, GL_TEXTURE_2D, feedbackFramebuffers.texture[order.second]);
     draw();
 
 //    // benchmark:
@@ -455,9 +722,52 @@ void TrophyShader::render() {
 
     handleExtraOutputs(order.first);
 
-    iPass.set(POST_PASS);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState().bindFramebuffer(0);
+    if (dedicatedPostPass && postProgram.works()) {
+        // what the SCENE_PASS just accumulated, with the bloom still on unit 1
+        glState().useProgram(postProgram);
+        postRect.set(iRect.value);
+        glState().bindTexture(0, GL_TEXTURE_2D, feedbackFramebuffers.texture[order.first]);
+    } else {
+        iPass.set(POST_PASS);
+    }
     draw();
+
+    ledBuffer.fence();
+    stateBuffer.fence();
+}
+
+static glm::mat3 rotateX(float degrees) {
+    // as rotateX() / rotateY() in fragment.glsl, column by column
+    const float c = std::cos(glm::radians(degrees));
+    const float s = std::sin(glm::radians(degrees));
+    return {
+        glm::vec3(1, 0, 0),
+        glm::vec3(0, c, -s),
+        glm::vec3(0, s, c)
+    };
+}
+
+static glm::mat3 rotateY(float degrees) {
+    const float c = std::cos(glm::radians(degrees));
+    const float s = std::sin(glm::radians(degrees));
+    return {
+        glm::vec3(c, 0, s),
+        glm::vec3(0, 1, 0),
+        glm::vec3(-s, 0, c)
+    };
+}
+
+void TrophyShader::setFrameConstants() {
+    if (currentMode != Shader::TrophyView) {
+        return;
+    }
+    const auto& params = state->params;
+    const float time = iTime.value;
+    pyramidRotation.set(rotateY(params.pyramidAngle + params.pyramidAngularVelocity * time));
+    camRotation.set(rotateX(params.camTilt));
+    lightDir.set(glm::normalize(glm::vec3(0, .125f + .05f * std::sin(.1f * time), 1)));
+    floorColor.set(glm::vec3(0, 0.73f - 0.2f * std::cos(time), 0.94f - 0.05f * std::sin(0.4f * time)));
 }
 
 void TrophyShader::handleExtraOutputs(int pingIndex) {
@@ -484,9 +794,11 @@ const std::pair<std::string, std::string> TrophyShader::lastReloadInfo() const {
     if (!lastReload.has_value()) {
         return result;
     }
-    if (reloadFailed) {
+    if (reloadPending) {
+        result.first = "-- compiling...";
+    } else if (reloadFailed) {
         result.first = "! FAILED !";
-        result.second = collectErrorLogs();
+        result.second = reloadError;
     } else {
         auto tm = *std::localtime(&lastReload.value());
         result.first = std::format("-- last: {:02d}:{:02d}:{:02d}",
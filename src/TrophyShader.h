@@ -5,6 +5,8 @@
 #ifndef DLTROPHY_SIMULATOR_TROPHYSHADER_H
 #define DLTROPHY_SIMULATOR_TROPHYSHADER_H
 
+#include <array>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -12,10 +14,15 @@
 
 #include <glad/gl.h>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat3x3.hpp>
 
 #include "glHelpers.h"
 #include "Config.h"
 #include "ShaderState.h"
+#include "LatencyHistogram.h"
+#include "ProgramBinaryCache.h"
+#include "ProgramBuilder.h"
 
 class TrophyShader {
 
@@ -23,25 +30,82 @@ private:
     ShaderMeta vertex = ShaderMeta(GL_VERTEX_SHADER);
     ShaderMeta fragment = ShaderMeta(GL_FRAGMENT_SHADER);
     ProgramMeta program;
+    ShaderMeta post = ShaderMeta(GL_FRAGMENT_SHADER);
+    ShaderMeta common = ShaderMeta(GL_FRAGMENT_SHADER);
+    // <-- never compiled on its own, goes into the other two where they #include "common.glsl"
+    [[nodiscard]]
+    ShaderMeta withCommon(ShaderMeta shader) const;
+    ProgramMeta postProgram{};
+    // <-- the POST_PASS, only reads the accumulated scene and the bloom (none for the LogoDevel shader)
+    void createPostProgram();
+    Uniform<glm::vec4> postRect = Uniform<glm::vec4>("iRect");
+    Uniform<int> postAccumulatedImage = Uniform<int>("iAccumulatedImage");
+    Uniform<int> postBloomImage = Uniform<int>("iBloomImage");
     ProgramMeta createProgram();
     bool loadShaderSources(const Config& config);
     void initializeProgram(const Config& config);
+    void bindProgramInterface();
     void teardown();
     std::optional<std::time_t> lastReload;
     bool reloadFailed = false;
+    std::string reloadError;
+    ProgramBuilder* builder;
+    // <-- builds the reloads in the background, if given
+    bool reloadPending = false;
+    bool takeReloadedProgram();
+    void adoptProgram(ProgramBuild build);
     Shader currentMode = TrophyView;
     std::string logoDevelModeError;
 
+    // the ShaderOptions are compiled in (as #defines), one program per combination that was asked for so far.
+    // `program` is always the one of currentVariant. The LogoDevel shader has its options as uniforms still.
+    static constexpr std::array<const char*, 4> optionDefines = {
+        "SHOW_GRID", "ACCUMULATE_FOREVER", "NO_STOCHASTIC_VARIATION", "ONLY_PYRAMID_FRAME"
+    };
+    std::map<unsigned, ProgramMeta> variants;
+    unsigned currentVariant = 0;
+    unsigned reloadVariant = 0;
+    // <-- what the pending reload is built for
+    [[nodiscard]]
+    unsigned variantOf(const ShaderOptions& options) const;
+    [[nodiscard]]
+    ShaderMeta fragmentVariant(unsigned variant) const;
+    void selectVariant();
+    void forgetVariants();
+
+    Uniform<glm::mat3> pyramidRotation = Uniform<glm::mat3>("pyramidRotation");
+    Uniform<glm::mat3> camRotation = Uniform<glm::mat3>("camRotation");
+    Uniform<glm::vec3> lightDir = Uniform<glm::vec3>("lightDir");
+    Uniform<glm::vec3> floorColor = Uniform<glm::vec3>("floorColor");
+    void setFrameConstants();
+
     GLuint vertexArrayObject = 0;
     GLuint vertexBufferObject = 0;
     void initVertices();
     static std::array<float, 18> createQuadVertices();
 
     ShaderState *state;
-    GLuint stateBufferId = 0;
-    GLuint definitionBufferId = 0;
+    GLuint positionBufferId = 0;
+    GLuint positionTextureId = 0;
+    StreamingBuffer ledBuffer;
+    StreamingBuffer stateBuffer;
+    std::vector<uint8_t> parameterImage;
+    // <-- the StateBuffer block as it is now, to tell what changed
+    UniformUpload uniformUpload = UniformUpload::Persistent;
+    BufferStorageFunction bufferStorage = nullptr;
+    static constexpr GLuint ledPositionsUnit = 2;
+    static constexpr GLuint ledColorsUnit = 3;
+    // <-- texture units, 0 and 1 are iPreviousImage and iBloomImage
+    static constexpr GLuint stateBindingPoint = 0;
     void initUniformBuffers();
-    void fillStateUniformBuffer();
+    void bindLedBuffers() const;
+    void initStreamingBuffers();
+    void fillParameterImage();
+    void uploadState();
+    LatencyHistogram uploadTime;
+    size_t uploadedBytes = 0;
+    size_t uploadedBytesTotal = 0;
+    size_t uploadFrames = 0;
 
     FramebufferPingPong feedbackFramebuffers{};
     Framebuffer ledsOnly{};
@@ -59,15 +123,37 @@ private:
     };
 
 public:
-    TrophyShader(Config& config, ShaderState *state);
+    TrophyShader(Config& config, ShaderState *state, ProgramBuilder* builder = nullptr);
     ~TrophyShader();
 
     void use();
     void render();
     void onRectChange(Size resolution, const Config& config);
 
+    void useUniformUpload(const std::string& mode);
+    [[nodiscard]]
+    const char* uniformUploadName() const { return stateBuffer.modeName(); }
+    [[nodiscard]]
+    LatencySummary uploadStats() const { return uploadTime.summary(); }
+    [[nodiscard]]
+    size_t uploadFenceWaits() const { return ledBuffer.fenceWaits + stateBuffer.fenceWaits; }
+    [[nodiscard]]
+    size_t lastUploadedBytes() const { return uploadedBytes; }
+    [[nodiscard]]
+    double averageUploadedBytes() const {
+        return uploadFrames > 0
+            ? static_cast<double>(uploadedBytesTotal) / static_cast<double>(uploadFrames)
+            : 0.;
+    }
+    void resetUploadStats();
+
+    static ProgramBinaryCache& programCache();
+
     void reload(const Config& config);
-    void mightHotReload(const Config& config);
+    void mightHotReload(const Config& config, const std::vector<std::string>& changedFiles);
+    [[nodiscard]]
+    std::vector<std::string> watchedFiles() const;
+    // <-- the shader sources on disk, for the FileWatcher (none of the embedded ones)
     [[nodiscard]]
     const std::pair<std::string, std::string> lastReloadInfo() const;
 
@@ -84,9 +170,15 @@ public:
     Uniform<glm::vec4> iMouse = Uniform<glm::vec4>("iMouse");
     Uniform<int> iPreviousImage = Uniform<int>("iPreviousImage");
     Uniform<int> iBloomImage = Uniform<int>("iBloomImage");
+    Uniform<int> nLeds = Uniform<int>("nLeds");
+    Uniform<int> ledPositions = Uniform<int>("ledPositions");
+    Uniform<int> ledColors = Uniform<int>("ledColors");
 
     void updateLedPositions() const;
 
+    bool dedicatedPostPass = true;
+    // <-- false traces the whole scene again in the POST_PASS, as it used to. Only to compare, cf. runBenchmark()
+
     bool shouldReadExtraOutputs = false;
     // these are for trying the PBO reading again, as soon as bog.
     int readingFromPingIndex = -1;
@@ -5,6 +5,10 @@
 #ifndef DLTROPHY_SIMULATOR_GLHELPERS_H
 #define DLTROPHY_SIMULATOR_GLHELPERS_H
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
 #include <utility>
 #include <variant>
 #include <utility>
@@ -13,6 +17,7 @@
 #include <filesystem>
 #include <string>
 #include <map>
+#include <vector>
 #include "FileHelper.h"
 #include "geometryHelpers.h"
 
@@ -26,7 +31,6 @@ struct ShaderMeta {
     GLuint id = 0;
     std::string error;
     std::string filePath;
-    std::filesystem::file_time_type fileTime;
 
     explicit ShaderMeta(GLenum type): type(type) {}
 
@@ -45,7 +49,6 @@ struct ShaderMeta {
         std::stringstream buffer;
         buffer << file.rdbuf();
         source = buffer.str();
-        fileTime = std::filesystem::last_write_time(filePath);
     }
 
     void takeEmbedded(const char embeddedSource[]) {
@@ -54,11 +57,21 @@ struct ShaderMeta {
     }
 
     void compile() {
+        submit();
+        check();
+    }
+
+    // only hands the source to the driver, which might compile in the background (cf. ProgramBuilder)
+    void submit() {
         error = "";
         id = glCreateShader(type);
         const char* source_str = source.c_str();
         glShaderSource(id, 1, &source_str, nullptr);
         glCompileShader(id);
+    }
+
+    // waits for the compiler, if it is not done yet
+    void check() {
         GLint status;
         glGetShaderiv(id, GL_COMPILE_STATUS, &status);
         if (status == GL_FALSE) {
@@ -70,15 +83,6 @@ struct ShaderMeta {
         }
     }
 
-    [[nodiscard]]
-    bool fileHasChanged() const {
-        if (usesEmbedded()) {
-            return false;
-        }
-        auto time = std::filesystem::last_write_time(filePath);
-        return fileTime != time;
-    }
-
     [[nodiscard]]
     bool usesEmbedded() const {
         return filePath.empty();
@@ -99,6 +103,152 @@ struct ProgramMeta {
     }
 };
 
+struct GlCallCounts {
+    size_t issued = 0;
+    size_t skipped = 0;
+    // <-- would not have changed anything
+};
+
+class GlStateCache {
+    /*
+     *  Shadows the program, the texture / framebuffer / uniform buffer bindings (and, in Uniform<T>, the values)
+     *  as they were set through here, and skips every call that would set them to what they already are.
+     *  It only knows what went through it: after anything else changed the bindings (creating textures,
+     *  framebuffers, programs...), call forget(). Dear ImGui restores what it touches, so that is fine.
+     */
+
+public:
+    static constexpr GLuint unknown = std::numeric_limits<GLuint>::max();
+
+    bool enabled = true;
+    // <-- otherwise every call is issued, for comparison
+
+private:
+    static constexpr GLuint textureUnits = 8;
+    // <-- all that the TrophyShader uses, further ones are just not shadowed
+
+    GLuint program = unknown;
+    GLuint activeUnit = unknown;
+    std::array<GLuint, textureUnits> textures2D{};
+    std::array<GLuint, textureUnits> textureBuffers{};
+    GLuint framebuffer = unknown;
+    std::map<GLuint, GLuint> uniformBuffers;
+    std::map<GLuint, std::vector<GLenum>> drawBuffersOf;
+    // <-- per framebuffer, as glDrawBuffers() belongs to that
+
+    GlCallCounts counting{};
+    GlCallCounts lastFrame_{};
+
+    bool changes(GLuint& shadowed, GLuint to) {
+        return changes(shadowed == to, [&] { shadowed = to; });
+    }
+
+    template<typename Update>
+    bool changes(bool same, Update update) {
+        if (enabled && same) {
+            counting.skipped++;
+            return false;
+        }
+        counting.issued++;
+        update();
+        return true;
+    }
+
+    GLuint* textureSlot(GLuint unit, GLenum target) {
+        if (unit >= textureUnits) {
+            return nullptr;
+        }
+        switch (target) {
+            case GL_TEXTURE_2D:
+                return &textures2D[unit];
+            case GL_TEXTURE_BUFFER:
+                return &textureBuffers[unit];
+            default:
+                return nullptr;
+        }
+    }
+
+public:
+    GlStateCache() {
+        forget();
+    }
+
+    void forget() {
+        program = unknown;
+        activeUnit = unknown;
+        textures2D.fill(unknown);
+        textureBuffers.fill(unknown);
+        framebuffer = unknown;
+        uniformBuffers.clear();
+        drawBuffersOf.clear();
+    }
+
+    // for uniform values etc. that are shadowed elsewhere: true if the call is to be issued
+    bool changes(bool same) {
+        return changes(same, [] {});
+    }
+
+    void useProgram(GLuint id) {
+        if (changes(program, id)) {
+            glUseProgram(id);
+        }
+    }
+
+    void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        auto* slot = textureSlot(unit, target);
+        if (slot && *slot == texture && enabled) {
+            counting.skipped++;
+            return;
+        }
+        if (changes(activeUnit, unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+        counting.issued++;
+        glBindTexture(target, texture);
+        if (slot) {
+            *slot = texture;
+        }
+    }
+
+    void bindFramebuffer(GLuint fbo) {
+        if (changes(framebuffer, fbo)) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        }
+    }
+
+    void bindUniformBuffer(GLuint bindingPoint, GLuint buffer) {
+        auto bound = uniformBuffers.find(bindingPoint);
+        const bool same = bound != uniformBuffers.end() && bound->second == buffer;
+        if (changes(same, [&] { uniformBuffers[bindingPoint] = buffer; })) {
+            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+        }
+    }
+
+    // into the framebuffer bound through bindFramebuffer()
+    void drawBuffers(GLsizei n, const GLenum* buffers) {
+        auto& shadowed = drawBuffersOf[framebuffer];
+        const bool same = framebuffer != unknown && std::equal(shadowed.begin(), shadowed.end(), buffers, buffers + n);
+        if (changes(same, [&] { shadowed.assign(buffers, buffers + n); })) {
+            glDrawBuffers(n, buffers);
+        }
+    }
+
+    // once per frame: what was counted since the last call
+    GlCallCounts endFrame() {
+        lastFrame_ = std::exchange(counting, {});
+        return lastFrame_;
+    }
+
+    [[nodiscard]]
+    GlCallCounts lastFrame() const { return lastFrame_; }
+};
+
+// one per GL context, and there is one
+inline GlStateCache& glState() {
+    static GlStateCache cache;
+    return cache;
+}
+
 template <typename T>
 struct Uniform {
 private:
@@ -106,6 +256,8 @@ private:
     std::string name;
     bool triedLoadLocation = false;
     bool hasLocationWarned = false;
+    std::optional<T> sent;
+    // <-- what the program has, unknown until set (the uniform values belong to the program)
 
 public:
     T value;
@@ -117,6 +269,7 @@ public:
     void loadLocation(GLuint program) {
         location = glGetUniformLocation(program, name.c_str());
         triedLoadLocation = true;
+        sent.reset();
     }
 
     void set() {
@@ -127,6 +280,10 @@ public:
             }
             return;
         }
+        if (!glState().changes(sent == value)) {
+            return;
+        }
+        sent = value;
         if constexpr (std::is_same_v<T, float>) {
             glUniform1f(location, value);
         } else if constexpr (std::is_same_v<T, int>) {
@@ -137,6 +294,8 @@ public:
             glUniform3f(location, value.x, value.y, value.z);
         } else if constexpr (std::is_same_v<T, glm::vec4>) {
             glUniform4f(location, value.x, value.y, value.z, value.w);
+        } else if constexpr (std::is_same_v<T, glm::mat3>) {
+            glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
         } else {
             throw std::runtime_error("Uniform.readFrom() called for undefined type");
         }
@@ -254,6 +413,286 @@ struct FramebufferPingPong {
     }
 };
 
+// not in our GL 3.3 loader, these come with GL 4.4 / ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (GLAD_API_PTR *BufferStorageFunction)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+static inline bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline BufferStorageFunction loadBufferStorage(GLADloadfunc load) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major * 10 + minor < 44 && !hasExtension("GL_ARB_buffer_storage")) {
+        return nullptr;
+    }
+    return reinterpret_cast<BufferStorageFunction>(load("glBufferStorage"));
+}
+
+enum class UniformUpload {
+    Persistent,
+    // <-- mapped once, needs GL 4.4 or ARB_buffer_storage, otherwise falls back to:
+    Orphaning,
+    SubData,
+    // <-- as it used to be, glBufferSubData() into one buffer, only there to compare
+};
+
+struct StreamingBuffer {
+    /*
+     *  For a uniform block or texture buffer that changes while rendering. It lives three times, a change goes
+     *  into the next copy and only that one is bound, so the CPU never waits for the GPU still reading what
+     *  it wrote before. With persistent mapping, there is a fence per copy for when the GPU lags behind by
+     *  all three; with orphaning, each copy is given up and written anew as a whole.
+     *
+     *  Only what changed is written: every copy remembers the byte range it misses since it was written last,
+     *  and as long as the bound one misses nothing, nothing is uploaded at all.
+     *  Three buffers instead of three ranges of one, as GL 3.3 can not point a texture at a range.
+     */
+
+    static constexpr int regions = 3;
+
+    struct ByteRange {
+        GLintptr from = 0;
+        GLintptr to = 0;
+
+        [[nodiscard]]
+        bool empty() const { return to <= from; }
+
+        void add(GLintptr addFrom, GLintptr addTo) {
+            if (empty()) {
+                from = addFrom;
+                to = addTo;
+                return;
+            }
+            from = std::min(from, addFrom);
+            to = std::max(to, addTo);
+        }
+    };
+
+    GLenum target = GL_UNIFORM_BUFFER;
+    // <-- or GL_TEXTURE_BUFFER, then each copy has its texture
+    UniformUpload mode = UniformUpload::SubData;
+    GLsizeiptr size = 0;
+    int region = 0;
+    std::array<GLuint, regions> ids{};
+    std::array<GLuint, regions> textures{};
+    std::array<ByteRange, regions> missing{};
+    std::array<GLsync, regions> fences{};
+    std::array<uint8_t*, regions> persistentMemory{};
+    std::vector<uint8_t> shadow;
+    // <-- only for markDifferences()
+    size_t fenceWaits = 0;
+    // <-- how often the GPU was indeed that far behind
+
+    [[nodiscard]]
+    int copies() const {
+        return mode == UniformUpload::SubData ? 1 : regions;
+    }
+
+    void initialize(GLenum bufferTarget, GLsizeiptr bufferSize, UniformUpload wanted,
+                    BufferStorageFunction bufferStorage, GLenum textureFormat = GL_RGBA8) {
+        teardown();
+        target = bufferTarget;
+        size = bufferSize;
+        region = 0;
+        fenceWaits = 0;
+        shadow.clear();
+        missing = {};
+        markDirty(0, size);
+        mode = wanted == UniformUpload::Persistent && !bufferStorage
+            ? UniformUpload::Orphaning
+            : wanted;
+
+        glGenBuffers(copies(), ids.data());
+        for (int r = 0; r < copies(); r++) {
+            glBindBuffer(target, ids[r]);
+            if (mode == UniformUpload::Persistent) {
+                constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                bufferStorage(target, size, nullptr, flags);
+                persistentMemory[r] = static_cast<uint8_t*>(glMapBufferRange(target, 0, size, flags));
+                if (!persistentMemory[r]) {
+                    glBindBuffer(target, 0);
+                    initialize(bufferTarget, bufferSize, UniformUpload::Orphaning, nullptr, textureFormat);
+                    return;
+                }
+            } else {
+                glBufferData(target, size, nullptr,
+                             mode == UniformUpload::SubData ? GL_DYNAMIC_DRAW : GL_STREAM_DRAW);
+            }
+        }
+        glBindBuffer(target, 0);
+
+        if (target == GL_TEXTURE_BUFFER) {
+            glGenTextures(copies(), textures.data());
+            for (int r = 0; r < copies(); r++) {
+                glBindTexture(GL_TEXTURE_BUFFER, textures[r]);
+                glTexBuffer(GL_TEXTURE_BUFFER, textureFormat, ids[r]);
+            }
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+        }
+    }
+
+    void teardown() {
+        for (int r = 0; r < regions; r++) {
+            if (persistentMemory[r]) {
+                glBindBuffer(target, ids[r]);
+                glUnmapBuffer(target);
+                persistentMemory[r] = nullptr;
+            }
+            if (fences[r]) {
+                glDeleteSync(fences[r]);
+                fences[r] = nullptr;
+            }
+            if (textures[r]) {
+                glDeleteTextures(1, &textures[r]);
+                textures[r] = 0;
+            }
+            if (ids[r]) {
+                glDeleteBuffers(1, &ids[r]);
+                ids[r] = 0;
+            }
+        }
+        glBindBuffer(target, 0);
+    }
+
+    [[nodiscard]]
+    const char* modeName() const {
+        switch (mode) {
+            case UniformUpload::Persistent:
+                return "persistent";
+            case UniformUpload::Orphaning:
+                return "orphaning";
+            default:
+                return "subdata";
+        }
+    }
+
+    static UniformUpload modeFrom(const std::string& name) {
+        if (name == "subdata") {
+            return UniformUpload::SubData;
+        }
+        if (name == "orphaning") {
+            return UniformUpload::Orphaning;
+        }
+        return UniformUpload::Persistent;
+    }
+
+    // bytes [from, to) changed
+    void markDirty(GLintptr from, GLintptr to) {
+        from = std::max<GLintptr>(from, 0);
+        to = std::min<GLintptr>(to, size);
+        if (to <= from) {
+            return;
+        }
+        for (auto& range : missing) {
+            range.add(from, to);
+        }
+    }
+
+    // for small blocks without any tracking of their own: marks what differs from the previous image
+    void markDifferences(const uint8_t* image) {
+        if (shadow.size() != static_cast<size_t>(size)) {
+            shadow.assign(image, image + size);
+            markDirty(0, size);
+            return;
+        }
+        GLintptr first = 0;
+        while (first < size && shadow[first] == image[first]) {
+            first++;
+        }
+        if (first == size) {
+            return;
+        }
+        GLintptr last = size;
+        while (shadow[last - 1] == image[last - 1]) {
+            last--;
+        }
+        std::memcpy(shadow.data() + first, image + first, last - first);
+        markDirty(first, last);
+    }
+
+    /**
+     *  image is the whole content as it is now, only what the bound copy misses of it is written,
+     *  into the next one. Returns how many bytes that were, then bind() it.
+     */
+    size_t upload(const uint8_t* image) {
+        if (missing[region].empty()) {
+            return 0;
+        }
+        region = (region + 1) % copies();
+        auto range = std::exchange(missing[region], {});
+        switch (mode) {
+            case UniformUpload::Persistent:
+                waitFor(fences[region]);
+                std::memcpy(persistentMemory[region] + range.from, image + range.from, range.to - range.from);
+                break;
+            case UniformUpload::Orphaning:
+                // the driver hands out fresh storage, so it is written as a whole
+                range = {0, size};
+                glBindBuffer(target, ids[region]);
+                glBufferData(target, size, image, GL_STREAM_DRAW);
+                glBindBuffer(target, 0);
+                break;
+            default:
+                glBindBuffer(target, ids[region]);
+                glBufferSubData(target, range.from, range.to - range.from, image + range.from);
+                glBindBuffer(target, 0);
+                break;
+        }
+        return range.to - range.from;
+    }
+
+    // the binding point of a uniform block, or the texture unit of a texture buffer
+    void bind(GLuint slot) const {
+        if (target == GL_TEXTURE_BUFFER) {
+            glState().bindTexture(slot, GL_TEXTURE_BUFFER, textures[region]);
+        } else {
+            glState().bindUniformBuffer(slot, ids[region]);
+        }
+    }
+
+    // after the last draw call of the frame, the bound copy might be read until then
+    void fence() {
+        if (mode != UniformUpload::Persistent) {
+            return;
+        }
+        if (fences[region]) {
+            glDeleteSync(fences[region]);
+        }
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+private:
+    void waitFor(GLsync& fence) {
+        if (!fence) {
+            return;
+        }
+        auto result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            fenceWaits++;
+            constexpr GLuint64 oneSecond = 1000000000;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, oneSecond);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+};
+
 static inline void initFloatTexture(GLuint texture, Size size) {
     glBindTexture(GL_TEXTURE_2D, texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
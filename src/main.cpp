@@ -1,11 +1,36 @@
+#include <atomic>
+#include <csignal>
 #include <iostream>
 #include "SimulatorApp.h"
+#include "UdpRelay.h"
+
+static std::atomic<bool> relaying{true};
+
+int runRelay(const Config& config) {
+#ifdef HAS_UDP_RELAY
+    UdpRelay relay(config.relaySettings());
+    std::signal(SIGINT, [](int) { relaying = false; });
+    std::signal(SIGTERM, [](int) { relaying = false; });
+    relay.run(relaying);
+    return 0;
+#else
+    std::cerr << "ERROR: The relay mode (-R) is only available on Linux." << std::endl;
+    return 1;
+#endif
+}
 
 int main(int argc, char* argv[]) {
 
     try {
         Config config(argc, argv);
+        if (config.relayMode) {
+            return runRelay(config);
+        }
         SimulatorApp app(config);
+        if (config.benchmarkFrames > 0) {
+            app.runBenchmark();
+            return 0;
+        }
         app.run();
         return 0;
     }
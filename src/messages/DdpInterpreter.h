@@ -0,0 +1,216 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_DDPINTERPRETER_H
+#define DLTROPHY_SIMULATOR_DDPINTERPRETER_H
+
+#include <algorithm>
+#include <atomic>
+#include <span>
+#include <vector>
+
+#include "../LED.h"
+#include "RgbKernel.h"
+
+struct DdpStats {
+    size_t frames = 0;
+    size_t missingSegments = 0;
+    // <-- a sequence number was skipped, or a packet did not continue where the previous one ended
+    size_t latePushes = 0;
+    // <-- the PUSH of a frame that was already given up on, these are not shown
+    size_t missingPushes = 0;
+    // <-- a new frame started (at offset 0) while the previous one was not pushed yet
+    size_t ignoredPackets = 0;
+
+    DdpStats& operator+=(const DdpStats& other) {
+        frames += other.frames;
+        missingSegments += other.missingSegments;
+        latePushes += other.latePushes;
+        missingPushes += other.missingPushes;
+        ignoredPackets += other.ignoredPackets;
+        return *this;
+    }
+};
+
+class DdpInterpreter {
+    /*
+     *  Distributed Display Protocol, cf. http://www.3waylabs.com/ddp/
+     *  (WLED sends this with up to 480 RGB pixels per packet, and the PUSH flag on the last one)
+     *
+     *  All packets are written into a back buffer, which is only handed over on PUSH,
+     *  so a frame is never shown half-updated.
+     *  The sequence number counts the packets (1..15, 0 if the sender does not number them), not the frames.
+     */
+
+public:
+    static constexpr int defaultPort = 4048;
+
+private:
+    static constexpr uint8_t flagVersionMask = 0xc0;
+    static constexpr uint8_t flagVersion1 = 0x40;
+    static constexpr uint8_t flagTimecode = 0x10;
+    static constexpr uint8_t flagReply = 0x04;
+    static constexpr uint8_t flagQuery = 0x02;
+    static constexpr uint8_t flagPush = 0x01;
+    static constexpr uint8_t sequenceMask = 0x0f;
+    static constexpr int maxSequenceSkip = 7;
+    // <-- further ahead than this, a packet counts as one that was overtaken
+    static constexpr uint8_t typeRgbw = 3;
+    // <-- the "TTT" bits of the data type, 1 is RGB (also what 0 = undefined means in practice)
+    static constexpr uint8_t firstReservedDestination = 246;
+    // <-- control, config (JSON), status... nothing we display
+    static constexpr size_t headerSize = 10;
+    static constexpr size_t timecodeSize = 4;
+
+    std::vector<LED> back;
+    size_t expectedOffset = 0;
+    uint8_t lastSequence = 0;
+    // <-- of the latest packet in order, 0 as long as none was numbered
+    uint8_t frameSequence = 0;
+    // <-- the first that belongs to the pending frame
+    bool frameStarted = false;
+
+    struct AtomicStats {
+        std::atomic<size_t> frames{0};
+        std::atomic<size_t> missingSegments{0};
+        std::atomic<size_t> latePushes{0};
+        std::atomic<size_t> missingPushes{0};
+        std::atomic<size_t> ignoredPackets{0};
+    } stats_;
+
+    static int sequenceDistance(uint8_t from, uint8_t to) {
+        // forwards, the numbers go 1..15 and then start over at 1
+        return (to + 15 - from) % 15;
+    }
+
+    static uint32_t bigEndian32(const uint8_t* bytes) {
+        return (static_cast<uint32_t>(bytes[0]) << 24)
+             | (static_cast<uint32_t>(bytes[1]) << 16)
+             | (static_cast<uint32_t>(bytes[2]) << 8)
+             | bytes[3];
+    }
+
+    void write(std::span<const uint8_t> data, size_t offset, size_t pixelSize) {
+        if (offset % pixelSize != 0) {
+            // WLED only ever splits at whole pixels, so not worth handling
+            stats_.ignoredPackets++;
+            return;
+        }
+        const size_t first = offset / pixelSize;
+        if (first >= back.size()) {
+            return;
+        }
+        const size_t count = std::min(data.size() / pixelSize, back.size() - first);
+        if (pixelSize == 3) {
+            RgbKernel::unpack(data.data(), back.data() + first, count);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            // RGBW: the white just adds up, we have no extra white chip to simulate
+            const auto* pixel = data.data() + i * pixelSize;
+            back[first + i] = LED(std::min(pixel[0] + pixel[3], 255),
+                                  std::min(pixel[1] + pixel[3], 255),
+                                  std::min(pixel[2] + pixel[3], 255));
+        }
+    }
+
+public:
+    explicit DdpInterpreter(size_t nLeds)
+    : back(nLeds) {}
+
+    /**
+     *  Writes the packet into the back buffer and calls commit(std::span<const LED>) with it on PUSH.
+     *  Returns false if this was not a DDP data packet.
+     */
+    template <typename Commit>
+    bool interpret(std::span<const uint8_t> bytes, Commit&& commit) {
+        if (bytes.size() < headerSize) {
+            return false;
+        }
+        const uint8_t flags = bytes[0];
+        const uint8_t sequence = bytes[1] & sequenceMask;
+        const uint8_t dataType = bytes[2];
+        const uint8_t destination = bytes[3];
+        const size_t offset = bigEndian32(bytes.data() + 4);
+        const size_t length = (bytes[8] << 8) | bytes[9];
+        const size_t dataStart = headerSize + (flags & flagTimecode ? timecodeSize : 0);
+
+        if ((flags & flagVersionMask) != flagVersion1
+            || (flags & (flagQuery | flagReply))
+            || destination >= firstReservedDestination
+            || bytes.size() < dataStart) {
+            stats_.ignoredPackets++;
+            return false;
+        }
+
+        const bool numbered = sequence != 0;
+        bool late = false;
+        bool skipped = false;
+        if (numbered && lastSequence != 0) {
+            const int ahead = sequenceDistance(lastSequence, sequence);
+            if (ahead == 0 || ahead > maxSequenceSkip) {
+                const bool ofPendingFrame = frameStarted
+                    && sequenceDistance(frameSequence, sequence) <= sequenceDistance(frameSequence, lastSequence);
+                if (!ofPendingFrame || (flags & flagPush)) {
+                    // of a frame that was pushed or given up on already, must not leak into the pending one
+                    if (flags & flagPush) {
+                        stats_.latePushes++;
+                    }
+                    return true;
+                }
+                late = true;
+                // <-- overtaken by a later one, but still part of the pending frame
+            }
+            skipped = ahead > 1 && !late;
+        }
+
+        if (!late) {
+            if (frameStarted && offset == 0 && expectedOffset > 0) {
+                stats_.missingPushes++;
+                frameStarted = false;
+            }
+            if (!frameStarted) {
+                frameStarted = true;
+                frameSequence = numbered && lastSequence != 0
+                    ? lastSequence % 15 + 1
+                    : sequence;
+                // <-- from the first one skipped on, as these might still come
+                expectedOffset = 0;
+            }
+            if (skipped || offset != expectedOffset) {
+                stats_.missingSegments++;
+            }
+            if (numbered) {
+                lastSequence = sequence;
+            }
+        }
+
+        const auto data = bytes.subspan(dataStart, std::min(length, bytes.size() - dataStart));
+        const size_t pixelSize = ((dataType >> 3) & 0x07) == typeRgbw ? 4 : 3;
+        write(data, offset, pixelSize);
+        if (!late) {
+            expectedOffset = offset + data.size();
+        }
+
+        if (flags & flagPush) {
+            stats_.frames++;
+            frameStarted = false;
+            commit(std::span<const LED>(back));
+        }
+        return true;
+    }
+
+    [[nodiscard]]
+    DdpStats stats() const {
+        return {
+            .frames = stats_.frames.load(),
+            .missingSegments = stats_.missingSegments.load(),
+            .latePushes = stats_.latePushes.load(),
+            .missingPushes = stats_.missingPushes.load(),
+            .ignoredPackets = stats_.ignoredPackets.load(),
+        };
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_DDPINTERPRETER_H
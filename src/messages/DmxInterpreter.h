@@ -0,0 +1,398 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_DMXINTERPRETER_H
+#define DLTROPHY_SIMULATOR_DMXINTERPRETER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "../LED.h"
+#include "RgbKernel.h"
+
+enum class DmxProtocol {
+    // E1.31 / ANSI "Streaming ACN", cf. https://tsp.esta.org/tsp/documents/docs/ANSI_E1-31-2018.pdf
+    Sacn,
+    // cf. https://art-net.org.uk/downloads/art-net.pdf
+    ArtNet,
+};
+
+struct DmxUniverseMapping {
+    // RGB triples, starting at DMX channel "channel" (1-based, as on the desk) of "universe",
+    // go to the LEDs "led" ... "led + count - 1". The universe is as on the wire,
+    // i.e. sACN counts from 1, Art-Net from 0 (Net << 8 | SubUni).
+    int universe = 1;
+    int channel = 1;
+    int led = 0;
+    int count = 170;
+
+    bool operator==(const DmxUniverseMapping& other) const = default;
+};
+
+struct DmxSettings {
+    bool sacn = false;
+    bool artNet = false;
+    std::vector<DmxUniverseMapping> universes;
+
+    bool operator==(const DmxSettings& other) const = default;
+
+    [[nodiscard]]
+    bool enabled() const {
+        return (sacn || artNet) && !universes.empty();
+    }
+};
+
+struct DmxStats {
+    size_t frames = 0;
+    size_t incompleteFrames = 0;
+    // <-- committed because a universe came again before all others were there
+    size_t syncedFrames = 0;
+    size_t lateUniverses = 0;
+    // <-- dropped because their sequence number was behind
+    size_t unmappedUniverses = 0;
+
+    DmxStats& operator+=(const DmxStats& other) {
+        frames += other.frames;
+        incompleteFrames += other.incompleteFrames;
+        syncedFrames += other.syncedFrames;
+        lateUniverses += other.lateUniverses;
+        unmappedUniverses += other.unmappedUniverses;
+        return *this;
+    }
+};
+
+class DmxInterpreter {
+    /*
+     *  Decodes sACN and Art-Net into the LED array and tells when a frame is complete.
+     *
+     *  Everything that depends on the config is put into tables once, so per packet there is
+     *  one lookup from universe to the (contiguous) mapping entries, and the RGB triples go
+     *  through the same kernel as DRGB. Nothing in here allocates after construction.
+     *
+     *  A frame is complete
+     *  - with a sync packet, once that arrives: for sACN, the one for the sync address the data packets named
+     *    (it goes to that universe's multicast group, so only if that is mapped as well, or sent unicast),
+     *    for Art-Net any ArtSync, or
+     *  - without, when every mapped universe arrived once. If one comes again before that,
+     *    its sequence has moved on, so the frame is committed as it is (counted as incomplete).
+     */
+
+public:
+    static constexpr int sacnPort = 5568;
+    static constexpr int artNetPort = 6454;
+
+private:
+    static constexpr uint16_t noSlot = UINT16_MAX;
+    static constexpr size_t nUniverses = 1 << 16;
+    static constexpr auto artSyncTimeout = std::chrono::seconds(4);
+    // <-- the Art-Net spec says: fall back to unsynchronized if there was no ArtSync for 4 seconds
+
+    struct Slot {
+        uint16_t universe;
+        uint16_t firstMapping;
+        uint16_t endMapping;
+        std::optional<uint8_t> lastSequence;
+        bool seen = false;
+    };
+
+    std::vector<DmxUniverseMapping> mappings;
+    // <-- sorted by universe, so that every Slot owns a contiguous range
+    std::vector<Slot> slots;
+    std::vector<uint16_t> slotOfUniverse;
+    size_t seenSlots = 0;
+    bool heldForSync = false;
+    uint16_t heldForSyncAddress = 0;
+    // <-- the sync packet that releases the held frame has to come for this address
+    std::optional<std::chrono::steady_clock::time_point> lastArtSync;
+
+    struct AtomicStats {
+        std::atomic<size_t> frames{0};
+        std::atomic<size_t> incompleteFrames{0};
+        std::atomic<size_t> syncedFrames{0};
+        std::atomic<size_t> lateUniverses{0};
+        std::atomic<size_t> unmappedUniverses{0};
+    } stats_;
+
+    struct DmxPacket {
+        bool isSync = false;
+        uint16_t universe = 0;
+        uint8_t sequence = 0;
+        bool sequenced = true;
+        bool synchronized = false;
+        uint16_t syncAddress = 0;
+        // <-- sACN: of the sync packet, or the one a data packet waits for. Art-Net's ArtSync has none, i.e. 0.
+        std::span<const uint8_t> channels;
+    };
+
+    static uint16_t bigEndian16(const uint8_t* bytes) {
+        return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+    }
+
+    static uint32_t bigEndian32(const uint8_t* bytes) {
+        return (static_cast<uint32_t>(bytes[0]) << 24)
+             | (static_cast<uint32_t>(bytes[1]) << 16)
+             | (static_cast<uint32_t>(bytes[2]) << 8)
+             | bytes[3];
+    }
+
+    static std::optional<DmxPacket> parseSacn(std::span<const uint8_t> bytes) {
+        // Root Layer (38 bytes), then either the Data Framing Layer + DMP Layer or the Sync Framing Layer.
+        static constexpr uint8_t acnIdentifier[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+        static constexpr uint32_t rootVectorData = 0x04;
+        static constexpr uint32_t rootVectorExtended = 0x08;
+        static constexpr uint32_t framingVectorData = 0x02;
+        static constexpr uint32_t framingVectorSync = 0x01;
+        static constexpr size_t syncPacketSize = 49;
+        static constexpr size_t dataHeaderSize = 126;
+
+        if (bytes.size() < syncPacketSize || std::memcmp(bytes.data() + 4, acnIdentifier, 12) != 0) {
+            return std::nullopt;
+        }
+        const auto rootVector = bigEndian32(bytes.data() + 18);
+        const auto framingVector = bigEndian32(bytes.data() + 40);
+
+        if (rootVector == rootVectorExtended && framingVector == framingVectorSync) {
+            return DmxPacket{
+                .isSync = true,
+                .universe = 0,
+                .sequence = bytes[44],
+                .sequenced = true,
+                .synchronized = false,
+                .syncAddress = bigEndian16(bytes.data() + 45),
+                .channels = {},
+            };
+        }
+
+        if (rootVector != rootVectorData || framingVector != framingVectorData || bytes.size() < dataHeaderSize) {
+            return std::nullopt;
+        }
+        const uint8_t options = bytes[112];
+        const bool preview = options & 0x80;
+        const uint8_t startCode = bytes[125];
+        if (preview || startCode != 0) {
+            return std::nullopt;
+        }
+        const size_t propertyCount = bigEndian16(bytes.data() + 123);
+        const size_t nChannels = std::min(propertyCount > 0 ? propertyCount - 1 : 0,
+                                          bytes.size() - dataHeaderSize);
+        const auto syncAddress = bigEndian16(bytes.data() + 109);
+        return DmxPacket{
+            .isSync = false,
+            .universe = bigEndian16(bytes.data() + 113),
+            .sequence = bytes[111],
+            .sequenced = true,
+            .synchronized = syncAddress != 0,
+            .syncAddress = syncAddress,
+            .channels = bytes.subspan(dataHeaderSize, nChannels),
+        };
+    }
+
+    std::optional<DmxPacket> parseArtNet(std::span<const uint8_t> bytes) {
+        // the OpCode is little endian, everything else in ArtDmx is big endian.
+        static constexpr uint8_t artNetIdentifier[8] = {'A', 'r', 't', '-', 'N', 'e', 't', 0};
+        static constexpr uint16_t opDmx = 0x5000;
+        static constexpr uint16_t opSync = 0x5200;
+        static constexpr size_t dmxHeaderSize = 18;
+
+        if (bytes.size() < 14 || std::memcmp(bytes.data(), artNetIdentifier, 8) != 0) {
+            return std::nullopt;
+        }
+        const auto opCode = static_cast<uint16_t>(bytes[8] | (bytes[9] << 8));
+        const auto now = std::chrono::steady_clock::now();
+
+        if (opCode == opSync) {
+            lastArtSync = now;
+            return DmxPacket{
+                .isSync = true,
+                .universe = 0,
+                .sequence = 0,
+                .sequenced = false,
+                .synchronized = false,
+                .syncAddress = 0,
+                .channels = {},
+            };
+        }
+        if (opCode != opDmx || bytes.size() < dmxHeaderSize) {
+            return std::nullopt;
+        }
+        const size_t length = bigEndian16(bytes.data() + 16);
+        return DmxPacket{
+            .isSync = false,
+            .universe = static_cast<uint16_t>(((bytes[15] & 0x7f) << 8) | bytes[14]),
+            .sequence = bytes[12],
+            .sequenced = bytes[12] != 0,
+            .synchronized = lastArtSync && now - *lastArtSync < artSyncTimeout,
+            .syncAddress = 0,
+            .channels = bytes.subspan(dmxHeaderSize, std::min(length, bytes.size() - dmxHeaderSize)),
+        };
+    }
+
+    static bool isLate(const Slot& slot, const DmxPacket& packet) {
+        // E1.31 6.7.2: discard if the sequence went back by less than 20, else accept (e.g. sender restarted)
+        if (!packet.sequenced || !slot.lastSequence) {
+            return false;
+        }
+        const auto difference = static_cast<int8_t>(packet.sequence - *slot.lastSequence);
+        return difference <= 0 && difference > -20;
+    }
+
+    void write(const Slot& slot, std::span<const uint8_t> channels, std::span<LED> leds) const {
+        for (uint16_t m = slot.firstMapping; m < slot.endMapping; m++) {
+            const auto& mapping = mappings[m];
+            const size_t offset = mapping.channel - 1;
+            if (offset >= channels.size() || static_cast<size_t>(mapping.led) >= leds.size()) {
+                continue;
+            }
+            const size_t count = std::min({
+                static_cast<size_t>(mapping.count),
+                (channels.size() - offset) / 3,
+                leds.size() - mapping.led
+            });
+            RgbKernel::unpack(channels.data() + offset, leds.data() + mapping.led, count);
+        }
+    }
+
+    template <typename Publish>
+    void commit(Publish&& publish) {
+        for (auto& slot : slots) {
+            slot.seen = false;
+        }
+        if (seenSlots < slots.size() && !heldForSync) {
+            stats_.incompleteFrames++;
+        }
+        if (heldForSync) {
+            stats_.syncedFrames++;
+        }
+        stats_.frames++;
+        seenSlots = 0;
+        heldForSync = false;
+        heldForSyncAddress = 0;
+        publish();
+    }
+
+public:
+    explicit DmxInterpreter(const std::vector<DmxUniverseMapping>& universes)
+    : slotOfUniverse(nUniverses, noSlot)
+    {
+        for (const auto& mapping : universes) {
+            if (mapping.universe < 0 || mapping.universe >= static_cast<int>(nUniverses)
+                || mapping.channel < 1 || mapping.led < 0 || mapping.count <= 0) {
+                std::cerr << "[DMX] ignore invalid mapping for universe " << mapping.universe << std::endl;
+                continue;
+            }
+            mappings.push_back(mapping);
+        }
+        std::stable_sort(mappings.begin(), mappings.end(), [](const auto& a, const auto& b) {
+            return a.universe < b.universe;
+        });
+
+        for (uint16_t m = 0; m < mappings.size(); m++) {
+            const auto universe = static_cast<uint16_t>(mappings[m].universe);
+            if (slotOfUniverse[universe] == noSlot) {
+                slotOfUniverse[universe] = static_cast<uint16_t>(slots.size());
+                slots.push_back(Slot{
+                    .universe = universe,
+                    .firstMapping = m,
+                    .endMapping = static_cast<uint16_t>(m + 1),
+                    .lastSequence = std::nullopt,
+                    .seen = false,
+                });
+            }
+            slots.back().endMapping = static_cast<uint16_t>(m + 1);
+        }
+    }
+
+    /**
+     *  Writes what is mapped into the LEDs, calls publish() whenever the frame is complete --
+     *  which can also be before the packet is written, if it already belongs to the next one.
+     *  Returns false if this was not a packet we understand.
+     */
+    template <typename Publish>
+    bool interpret(DmxProtocol protocol,
+                   std::span<const uint8_t> bytes,
+                   std::span<LED> leds,
+                   Publish&& publish) {
+        const auto packet = protocol == DmxProtocol::Sacn
+            ? parseSacn(bytes)
+            : parseArtNet(bytes);
+        if (!packet) {
+            return false;
+        }
+
+        if (packet->isSync) {
+            // a sync for another address releases some other receiver's universes, not ours
+            if (heldForSync && packet->syncAddress == heldForSyncAddress) {
+                commit(publish);
+            }
+            return true;
+        }
+
+        const auto slotIndex = slotOfUniverse[packet->universe];
+        if (slotIndex == noSlot) {
+            stats_.unmappedUniverses++;
+            return true;
+        }
+        auto& slot = slots[slotIndex];
+        if (isLate(slot, *packet)) {
+            stats_.lateUniverses++;
+            return true;
+        }
+        slot.lastSequence = packet->sequence;
+
+        if (slot.seen && !packet->synchronized) {
+            commit(publish);
+        }
+        write(slot, packet->channels, leds);
+        if (!slot.seen) {
+            slot.seen = true;
+            seenSlots++;
+        }
+        heldForSync = packet->synchronized;
+        heldForSyncAddress = packet->syncAddress;
+
+        if (!heldForSync && seenSlots == slots.size()) {
+            commit(publish);
+        }
+        return true;
+    }
+
+    [[nodiscard]]
+    size_t mappedUniverses() const {
+        return slots.size();
+    }
+
+    [[nodiscard]]
+    DmxStats stats() const {
+        return {
+            .frames = stats_.frames.load(),
+            .incompleteFrames = stats_.incompleteFrames.load(),
+            .syncedFrames = stats_.syncedFrames.load(),
+            .lateUniverses = stats_.lateUniverses.load(),
+            .unmappedUniverses = stats_.unmappedUniverses.load(),
+        };
+    }
+
+    // the multicast group a sACN sender uses for this universe, i.e. 239.255.<high byte>.<low byte>
+    static uint32_t sacnMulticastGroup(uint16_t universe) {
+        return (239u << 24) | (255u << 16) | universe;
+    }
+
+    [[nodiscard]]
+    std::vector<uint16_t> universes() const {
+        std::vector<uint16_t> result;
+        for (const auto& slot : slots) {
+            result.push_back(slot.universe);
+        }
+        return result;
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_DMXINTERPRETER_H
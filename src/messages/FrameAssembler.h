@@ -0,0 +1,175 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_FRAMEASSEMBLER_H
+#define DLTROPHY_SIMULATOR_FRAMEASSEMBLER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../LED.h"
+#include "UdpInterpreter.h"
+
+enum class FrameCommitRule {
+    Packet,
+    // <-- every packet is a frame of its own, as before. Tears if the sender splits its frames.
+    Wrap,
+    // <-- a packet starting at or before the previous one begins the next frame
+    Complete,
+    // <-- once every LED was written since the last frame. Does not apply to WARLS, there every packet is a frame.
+};
+
+struct FrameAssemblyStats {
+    size_t frames = 0;
+    size_t byGap = 0;
+    // <-- committed because the sender paused, not because the rule fired
+
+    FrameAssemblyStats& operator+=(const FrameAssemblyStats& other) {
+        frames += other.frames;
+        byGap += other.byGap;
+        return *this;
+    }
+};
+
+class FrameAssembler {
+    /*
+     *  Decides when the WLED realtime packets (WARLS / DRGB / DNRGB) that were decoded into the back buffer
+     *  make up a frame, as these protocols do not mark it themselves (unlike DDP or sACN).
+     *  Independent of the rule, a frame is also committed when nothing arrived for a while.
+     *
+     *  Only used from the ingest thread, except for stats().
+     */
+
+private:
+    FrameCommitRule rule;
+    std::chrono::steady_clock::duration gap;
+    size_t nLeds;
+
+    bool pending = false;
+    std::chrono::steady_clock::time_point lastPacketAt;
+    std::optional<LedIndex> previousStart;
+
+    std::vector<uint64_t> covered;
+    // <-- one bit per LED, only for FrameCommitRule::Complete
+    size_t coveredCount = 0;
+
+    std::atomic<size_t> frames_{0};
+    std::atomic<size_t> byGap_{0};
+
+    void cover(LedIndex first, LedIndex last) {
+        for (size_t index = first; index <= last && index < nLeds; index++) {
+            auto& word = covered[index / 64];
+            const auto bit = uint64_t{1} << (index % 64);
+            if (!(word & bit)) {
+                word |= bit;
+                coveredCount++;
+            }
+        }
+    }
+
+public:
+    FrameAssembler(FrameCommitRule rule, std::chrono::milliseconds gap, size_t nLeds)
+    : rule(rule),
+      gap(gap),
+      nLeds(nLeds),
+      covered((nLeds + 63) / 64)
+    {}
+
+    static FrameCommitRule ruleFrom(const std::string& name) {
+        if (name == "packet") {
+            return FrameCommitRule::Packet;
+        }
+        if (name == "complete") {
+            return FrameCommitRule::Complete;
+        }
+        return FrameCommitRule::Wrap;
+    }
+
+    // before the packet is decoded -- true means: commit what is there, it belongs to the previous frame.
+    bool startsNewFrame(std::span<const uint8_t> bytes) {
+        if (rule != FrameCommitRule::Wrap) {
+            return false;
+        }
+        const auto start = UdpInterpreter::startIndex(bytes);
+        if (!start) {
+            return false;
+        }
+        const bool wrapped = pending && previousStart && *start <= *previousStart;
+        previousStart = start;
+        return wrapped;
+    }
+
+    // after it was decoded -- true means: it completed the frame.
+    bool completes(const ProtocolMessage& message) {
+        pending = true;
+        lastPacketAt = std::chrono::steady_clock::now();
+        switch (rule) {
+            case FrameCommitRule::Packet:
+                return true;
+            case FrameCommitRule::Complete:
+                if (message.protocol == RealtimeProtocol::WARLS) {
+                    // index-addressed, first..last says nothing about what is in between.
+                    // WARLS only reaches 256 LEDs anyway, i.e. the sender has no reason to split its frames.
+                    return true;
+                }
+                if (message.ledCount > 0) {
+                    // <-- contiguous from here on, so first..last is exactly what was written
+                    cover(message.firstIndex, message.lastIndex);
+                }
+                return coveredCount >= nLeds;
+            default:
+                return false;
+        }
+    }
+
+    // for when nothing arrived
+    bool timedOut(std::chrono::steady_clock::time_point now) const {
+        return pending
+            && gap.count() > 0
+            && now - lastPacketAt >= gap;
+    }
+
+    // when timedOut() will be true, for the ingest to know how long it may wait
+    [[nodiscard]]
+    std::optional<std::chrono::steady_clock::time_point> deadline() const {
+        if (!pending || gap.count() <= 0) {
+            return std::nullopt;
+        }
+        return lastPacketAt + gap;
+    }
+
+    void committed(bool byTimeout = false) {
+        if (!pending) {
+            return;
+        }
+        pending = false;
+        if (coveredCount > 0) {
+            std::fill(covered.begin(), covered.end(), 0);
+            coveredCount = 0;
+        }
+        frames_++;
+        if (byTimeout) {
+            byGap_++;
+        }
+    }
+
+    [[nodiscard]]
+    bool hasPending() const { return pending; }
+
+    [[nodiscard]]
+    FrameAssemblyStats stats() const {
+        return {
+            .frames = frames_.load(),
+            .byGap = byGap_.load(),
+        };
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_FRAMEASSEMBLER_H
@@ -0,0 +1,167 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_INGESTSOURCE_H
+#define DLTROPHY_SIMULATOR_INGESTSOURCE_H
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "PacketSource.h"
+#include "LedFrame.h"
+#include "FrameAssembler.h"
+#include "DdpInterpreter.h"
+#include "DmxInterpreter.h"
+#include "KernelTimestamp.h"
+#include "SpscRing.h"
+
+enum class SenderSeparation {
+    None,
+    // <-- everything lands in one LED state, as it used to
+    Address,
+    // <-- one state per IP, i.e. per ESP32
+    AddressAndPort,
+    // <-- also by the sender's port, e.g. for several mock senders on one machine
+};
+
+struct SourceStats {
+    PacketSource sender;
+    const char* label = nullptr;
+    // <-- for sources that are no network sender
+    size_t packets = 0;
+    size_t frames = 0;
+    double packetsPerSecond = 0;
+    double silentSeconds = 0;
+    // <-- since its last packet
+    bool stale = false;
+    size_t dropouts = 0;
+    // <-- how often it was silent for longer than IngestSource::staleAfter, and came back
+
+    [[nodiscard]]
+    std::string name() const {
+        if (label) {
+            return label;
+        }
+        if (sender.ipv4 == 0) {
+            return "all senders";
+        }
+        return sender.port == 0
+            ? sender.host()
+            : sender.toString();
+    }
+};
+
+struct IngestSource {
+    /*
+     *  All that is kept per sender: its own back buffer with its frame assembly, the stateful
+     *  interpreters, so that two senders can never write into one frame, and its own ring to the render loop,
+     *  so that a sender with a backlog cannot hold up the frames of the others.
+     *  Created on the ingest thread when the sender first shows up, never removed while the ingest runs.
+     */
+
+    static constexpr auto staleAfter = std::chrono::seconds(1);
+    static constexpr size_t ringSize = 16;
+    // <-- with the playout buffer, the render loop takes all frames, which can come in bursts
+
+    const PacketSource sender;
+    const size_t index;
+    const char* const label;
+
+    LedFrame accumulated;
+    SpscRing<LedFrame, ringSize> ring;
+    FrameAssembler assembler;
+    std::optional<DdpInterpreter> ddp;
+    std::optional<DmxInterpreter> dmx;
+    DeltaState delta;
+    std::optional<KernelTime> lastArrival;
+    std::chrono::steady_clock::time_point arrivedAt;
+    // <-- of the packet that is being decoded, goes into the frame along with it
+
+    std::atomic<size_t> packets{0};
+    std::atomic<std::chrono::steady_clock::rep> lastPacketAt{0};
+    std::atomic<size_t> dropouts{0};
+    std::atomic<double> packetsPerSecond{0};
+    size_t statsPackets = 0;
+    // <-- only on the ingest thread
+
+    IngestSource(const PacketSource& sender, const char* label, size_t index, size_t nLeds,
+                 FrameCommitRule rule, std::chrono::milliseconds frameGap,
+                 bool withDdp, const std::vector<DmxUniverseMapping>& dmxUniverses)
+    : sender(sender),
+      index(index),
+      label(label),
+      ring(LedFrame{.leds = std::vector<LED>(nLeds), .source = index}),
+      assembler(rule, frameGap, nLeds)
+    {
+        accumulated.leds.resize(nLeds);
+        accumulated.source = index;
+        if (withDdp) {
+            ddp.emplace(nLeds);
+        }
+        if (!dmxUniverses.empty()) {
+            dmx.emplace(dmxUniverses);
+        }
+    }
+
+    static PacketSource keyOf(const PacketSource& sender, SenderSeparation separation) {
+        switch (separation) {
+            case SenderSeparation::None:
+                return PacketSource{};
+            case SenderSeparation::Address:
+                return PacketSource{.ipv4 = sender.ipv4};
+            default:
+                return sender;
+        }
+    }
+
+    static SenderSeparation separationFrom(const std::string& name) {
+        if (name == "none") {
+            return SenderSeparation::None;
+        }
+        if (name == "address+port") {
+            return SenderSeparation::AddressAndPort;
+        }
+        return SenderSeparation::Address;
+    }
+
+    void received(std::chrono::steady_clock::time_point now) {
+        const auto previous = lastPacketAt.load(std::memory_order_relaxed);
+        const auto nowTicks = now.time_since_epoch().count();
+        if (previous != 0 && std::chrono::steady_clock::duration(nowTicks - previous) >= staleAfter) {
+            dropouts++;
+        }
+        lastPacketAt.store(nowTicks, std::memory_order_relaxed);
+        packets++;
+    }
+
+    [[nodiscard]]
+    SourceStats stats(std::chrono::steady_clock::time_point now) const {
+        const auto last = std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(lastPacketAt.load(std::memory_order_relaxed))
+        );
+        const auto silent = now - last;
+        size_t frames = assembler.stats().frames;
+        if (ddp) {
+            frames += ddp->stats().frames;
+        }
+        if (dmx) {
+            frames += dmx->stats().frames;
+        }
+        return {
+            .sender = sender,
+            .label = label,
+            .packets = packets.load(),
+            .frames = frames,
+            .packetsPerSecond = packetsPerSecond.load(),
+            .silentSeconds = std::chrono::duration<double>(silent).count(),
+            .stale = silent >= staleAfter,
+            .dropouts = dropouts.load(),
+        };
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_INGESTSOURCE_H
@@ -0,0 +1,69 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_KERNELTIMESTAMP_H
+#define DLTROPHY_SIMULATOR_KERNELTIMESTAMP_H
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#ifdef __linux__
+#include <cstring>
+#include <ctime>
+#include <sys/socket.h>
+#endif
+
+// when the datagram arrived at the kernel, i.e. before any of our threads got to see it.
+// SO_TIMESTAMPNS stamps with CLOCK_REALTIME, which is what the system_clock is on Linux.
+using KernelTime = std::chrono::system_clock::time_point;
+
+namespace KernelTimestamp {
+
+    // onto the clock the render loop uses, as it was that long ago. Without a stamp, that is now.
+    inline std::chrono::steady_clock::time_point onSteadyClock(const std::optional<KernelTime>& stamp) {
+        const auto now = std::chrono::steady_clock::now();
+        if (!stamp) {
+            return now;
+        }
+        const auto ago = std::chrono::system_clock::now() - *stamp;
+        return now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::max(ago, ago.zero()));
+    }
+
+#ifdef __linux__
+    constexpr size_t controlSize = CMSG_SPACE(sizeof(timespec));
+    // <-- what the control buffer of recvmsg() needs to have room for
+
+    inline bool enable(int fd) {
+        const int on = 1;
+        return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+    }
+
+    inline std::optional<KernelTime> from(const msghdr& header) {
+        if (header.msg_flags & MSG_CTRUNC) {
+            return std::nullopt;
+        }
+        // CMSG_NXTHDR wants it non-const, though it does not write anything
+        auto& message = const_cast<msghdr&>(header);
+        for (auto* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS) {
+                continue;
+            }
+            timespec ts{};
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return KernelTime(std::chrono::duration_cast<KernelTime::duration>(
+                std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)
+            ));
+        }
+        return std::nullopt;
+    }
+#else
+    inline bool enable(int) {
+        return false;
+    }
+#endif
+
+}
+
+#endif //DLTROPHY_SIMULATOR_KERNELTIMESTAMP_H
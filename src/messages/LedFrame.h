@@ -0,0 +1,28 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_LEDFRAME_H
+#define DLTROPHY_SIMULATOR_LEDFRAME_H
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "../LED.h"
+#include "UdpInterpreter.h"
+
+struct LedFrame {
+    std::vector<LED> leds;
+    std::optional<ProtocolMessage> lastMessage;
+    size_t packets = 0;
+    // <-- how many packets went into this frame since the previous one
+    std::chrono::steady_clock::time_point receivedAt;
+    // <-- when the newest packet in it arrived (by the kernel's stamp, if there is one), for the playout
+    std::chrono::steady_clock::time_point decodedAt;
+    // <-- of the newest packet in it, for the render loop to measure how long until it is drawn
+    size_t source = 0;
+    // <-- which sender it came from, cf. UdpIngest::sourceStats()
+};
+
+#endif //DLTROPHY_SIMULATOR_LEDFRAME_H
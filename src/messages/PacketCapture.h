@@ -0,0 +1,183 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_PACKETCAPTURE_H
+#define DLTROPHY_SIMULATOR_PACKETCAPTURE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "PacketSource.h"
+
+/*
+ *  Capture file, all numbers little endian:
+ *      8 bytes magic "DLTCAP01"
+ *  then per datagram:
+ *      u64 nanoseconds since the capture started (steady clock)
+ *      u32 IPv4 of the sender, u16 its port
+ *      u8  which socket it came in on (CaptureStream), u8 reserved
+ *      u16 payload length, followed by the payload
+ */
+
+enum class CaptureStream : uint8_t {
+    Wled = 0,
+    Sacn = 1,
+    ArtNet = 2,
+    Ddp = 3,
+};
+
+struct CapturedPacket {
+    std::chrono::nanoseconds at;
+    PacketSource source;
+    CaptureStream stream;
+    std::span<const uint8_t> bytes;
+    // <-- only valid until the next read
+};
+
+namespace PacketCaptureFormat {
+    constexpr std::array<char, 8> magic{'D', 'L', 'T', 'C', 'A', 'P', '0', '1'};
+    constexpr size_t recordHeaderSize = 18;
+    constexpr size_t maxPayload = 0xffff;
+
+    template <typename T>
+    void put(uint8_t*& at, T value) {
+        for (size_t i = 0; i < sizeof(T); i++) {
+            *at++ = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    template <typename T>
+    T get(const uint8_t*& at) {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value |= static_cast<T>(*at++) << (8 * i);
+        }
+        return value;
+    }
+}
+
+class CaptureWriter {
+    /*
+     *  Written from the ingest thread only. Collects into its own buffer, which is preallocated,
+     *  so writing a packet is a memcpy - the file only gets to see it in chunks.
+     */
+
+private:
+    static constexpr size_t flushSize = 1 << 20;
+
+    std::string path;
+    std::ofstream file;
+    std::vector<uint8_t> pending;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<size_t> packets_{0};
+
+    void flush() {
+        file.write(reinterpret_cast<const char*>(pending.data()), static_cast<std::streamsize>(pending.size()));
+        pending.clear();
+    }
+
+public:
+    explicit CaptureWriter(const std::string& path)
+    : path(path),
+      file(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!file.is_open()) {
+            throw std::runtime_error(std::format("Cannot write capture file {0}", path));
+        }
+        file.write(PacketCaptureFormat::magic.data(), PacketCaptureFormat::magic.size());
+        pending.reserve(flushSize + PacketCaptureFormat::recordHeaderSize + PacketCaptureFormat::maxPayload);
+        std::cout << "[Capture] Recording all received packets to " << path << std::endl;
+    }
+
+    ~CaptureWriter() {
+        flush();
+        std::cout << "[Capture] Recorded " << packets_ << " packets to " << path << std::endl;
+    }
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    void write(CaptureStream stream, const PacketSource& source, std::span<const uint8_t> bytes) {
+        const auto at = std::chrono::steady_clock::now() - start;
+        const auto length = std::min(bytes.size(), PacketCaptureFormat::maxPayload);
+
+        const auto offset = pending.size();
+        pending.resize(offset + PacketCaptureFormat::recordHeaderSize + length);
+        auto* header = pending.data() + offset;
+        PacketCaptureFormat::put<uint64_t>(header, std::chrono::duration_cast<std::chrono::nanoseconds>(at).count());
+        PacketCaptureFormat::put<uint32_t>(header, source.ipv4);
+        PacketCaptureFormat::put<uint16_t>(header, source.port);
+        PacketCaptureFormat::put<uint8_t>(header, static_cast<uint8_t>(stream));
+        PacketCaptureFormat::put<uint8_t>(header, 0);
+        PacketCaptureFormat::put<uint16_t>(header, static_cast<uint16_t>(length));
+        std::memcpy(header, bytes.data(), length);
+        packets_++;
+
+        if (pending.size() >= flushSize) {
+            flush();
+        }
+    }
+
+    [[nodiscard]]
+    size_t packets() const { return packets_.load(); }
+
+    [[nodiscard]]
+    const std::string& filename() const { return path; }
+};
+
+class CaptureReader {
+private:
+    std::string path;
+    std::ifstream file;
+    std::array<uint8_t, PacketCaptureFormat::maxPayload> buffer{};
+
+public:
+    explicit CaptureReader(const std::string& path)
+    : path(path),
+      file(path, std::ios::binary)
+    {
+        std::array<char, PacketCaptureFormat::magic.size()> magic{};
+        file.read(magic.data(), magic.size());
+        if (!file || magic != PacketCaptureFormat::magic) {
+            throw std::runtime_error(std::format("{0} is no capture file (or an incompatible one)", path));
+        }
+    }
+
+    // nullopt at the end, or if the file was cut off.
+    std::optional<CapturedPacket> next() {
+        std::array<uint8_t, PacketCaptureFormat::recordHeaderSize> header{};
+        if (!file.read(reinterpret_cast<char*>(header.data()), header.size())) {
+            return std::nullopt;
+        }
+        const uint8_t* at = header.data();
+        CapturedPacket packet{};
+        packet.at = std::chrono::nanoseconds(PacketCaptureFormat::get<uint64_t>(at));
+        packet.source.ipv4 = PacketCaptureFormat::get<uint32_t>(at);
+        packet.source.port = PacketCaptureFormat::get<uint16_t>(at);
+        packet.stream = static_cast<CaptureStream>(PacketCaptureFormat::get<uint8_t>(at));
+        PacketCaptureFormat::get<uint8_t>(at);
+        const auto length = PacketCaptureFormat::get<uint16_t>(at);
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), length)) {
+            return std::nullopt;
+        }
+        packet.bytes = std::span<const uint8_t>(buffer.data(), length);
+        return packet;
+    }
+
+    [[nodiscard]]
+    const std::string& filename() const { return path; }
+};
+
+#endif //DLTROPHY_SIMULATOR_PACKETCAPTURE_H
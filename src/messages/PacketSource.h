@@ -0,0 +1,59 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_PACKETSOURCE_H
+#define DLTROPHY_SIMULATOR_PACKETSOURCE_H
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+
+struct PacketSource {
+    // fixed size, so the per-packet path does not need to allocate.
+    // only IPv4 for now (as is WLED), formatted only when someone wants to read it.
+    uint32_t ipv4 = 0;
+    uint16_t port = 0;
+
+    bool operator==(const PacketSource& other) const = default;
+
+    [[nodiscard]]
+    std::string host() const {
+        return std::format("{}.{}.{}.{}",
+                           (ipv4 >> 24) & 0xff,
+                           (ipv4 >> 16) & 0xff,
+                           (ipv4 >> 8) & 0xff,
+                           ipv4 & 0xff);
+    }
+
+    [[nodiscard]]
+    std::string toString() const {
+        return std::format("{}:{}", host(), port);
+    }
+
+    static PacketSource from(std::string_view host, uint16_t port) {
+        // parses "a.b.c.d" by hand, anything else (IPv6, names) just stays 0.0.0.0
+        PacketSource result{.port = port};
+        uint32_t part = 0;
+        int dots = 0;
+        for (char c : host) {
+            if (c >= '0' && c <= '9') {
+                part = 10 * part + (c - '0');
+            } else if (c == '.' && dots < 3) {
+                result.ipv4 = (result.ipv4 << 8) | (part & 0xff);
+                part = 0;
+                dots++;
+            } else {
+                return PacketSource{.port = port};
+            }
+        }
+        if (dots != 3) {
+            return PacketSource{.port = port};
+        }
+        result.ipv4 = (result.ipv4 << 8) | (part & 0xff);
+        return result;
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_PACKETSOURCE_H
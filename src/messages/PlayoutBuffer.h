@@ -0,0 +1,190 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_PLAYOUTBUFFER_H
+#define DLTROPHY_SIMULATOR_PLAYOUTBUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+#include "LedFrame.h"
+#include "../monitor/LatencyHistogram.h"
+
+struct PlayoutSettings {
+    bool enabled = false;
+    int minDelayMs = 5;
+    int maxDelayMs = 100;
+    float smoothness = 0.5;
+    // <-- 0 keeps the delay as low as the jitter allows, 1 waits long enough for nearly every burst
+
+    bool operator==(const PlayoutSettings& other) const = default;
+};
+
+struct PlayoutStats {
+    double delayMillis = 0;
+    double cadenceMillis = 0;
+    double jitterMillis = 0;
+    size_t buffered = 0;
+    size_t released = 0;
+    size_t late = 0;
+    // <-- arrived after they should have been shown already, shown right away then
+    size_t dropped = 0;
+    // <-- never shown, because a newer frame was due at the same time or the buffer was full
+    LatencySummary waited;
+    // <-- from being received to being released
+};
+
+class PlayoutBuffer {
+    /*
+     *  Optional stage between the ingest and the ShaderState, for senders whose frames arrive in bursts
+     *  (WLED over WiFi): estimates the sender's frame interval and the jitter around it, puts every frame
+     *  on that steady timeline and holds it back by a delay that follows the jitter, within the configured
+     *  bounds. The frames are swapped in and out of a fixed pool, nothing allocates.
+     *
+     *  Only used from the render thread.
+     */
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Millis = std::chrono::duration<double, std::milli>;
+
+    static constexpr size_t capacity = 32;
+    static constexpr size_t cadenceWindow = 64;
+    // <-- the sender's interval is averaged over that many frames, i.e. over whole bursts
+    static constexpr double jitterWeight = 1. / 16;
+    static constexpr double driftWeight = 1. / 16;
+    // <-- how fast the timeline follows a sender whose clock runs a bit different than ours
+    static constexpr double delayWeight = 1. / 32;
+    // <-- slow, because every change of the delay speeds up or slows down the playback a bit
+    static constexpr Millis pauseInterval{500};
+    // <-- longer than that without a frame, the sender paused and we start over
+
+    PlayoutSettings settings;
+
+    std::array<LedFrame, capacity> pool;
+    std::array<Clock::time_point, capacity> due{};
+    size_t first = 0;
+    size_t count = 0;
+
+    std::array<Clock::time_point, cadenceWindow> arrivals{};
+    size_t nArrivals = 0;
+    std::optional<Clock::time_point> timeline;
+    Millis cadence{20};
+    Millis jitter{0};
+    Millis delay;
+
+    size_t released = 0;
+    size_t late = 0;
+    size_t dropped = 0;
+    LatencyHistogram waited;
+
+    [[nodiscard]]
+    Millis minDelay() const { return Millis(settings.minDelayMs); }
+
+    [[nodiscard]]
+    Millis maxDelay() const { return Millis(std::max(settings.maxDelayMs, settings.minDelayMs)); }
+
+    Clock::time_point schedule(Clock::time_point arrival) {
+        const auto& lastArrival = arrivals[(nArrivals + cadenceWindow - 1) % cadenceWindow];
+        if (nArrivals == 0 || arrival - lastArrival >= pauseInterval) {
+            nArrivals = 0;
+            timeline.reset();
+        }
+        const auto& oldestArrival = arrivals[nArrivals < cadenceWindow ? 0 : nArrivals % cadenceWindow];
+        if (nArrivals > 0) {
+            cadence = Millis(arrival - oldestArrival) / static_cast<double>(std::min(nArrivals, cadenceWindow));
+        }
+        arrivals[nArrivals % cadenceWindow] = arrival;
+        nArrivals++;
+
+        if (timeline) {
+            auto expected = *timeline + std::chrono::duration_cast<Clock::duration>(cadence);
+            const Millis deviation = arrival - expected;
+            if (std::abs(deviation.count()) > maxDelay().count()) {
+                expected = arrival;
+            } else {
+                jitter += (Millis(std::abs(deviation.count())) - jitter) * jitterWeight;
+                expected += std::chrono::duration_cast<Clock::duration>(deviation * driftWeight);
+            }
+            timeline = expected;
+        } else {
+            timeline = arrival;
+        }
+
+        const auto target = std::clamp(
+            minDelay() + (2 + 4 * static_cast<double>(settings.smoothness)) * jitter,
+            minDelay(),
+            maxDelay()
+        );
+        delay += (target - delay) * delayWeight;
+        return *timeline + std::chrono::duration_cast<Clock::duration>(delay);
+    }
+
+public:
+    explicit PlayoutBuffer(const PlayoutSettings& settings)
+    : settings(settings),
+      delay(settings.minDelayMs)
+    {}
+
+    // swaps the frame in, i.e. it gets back an older buffer to take the next one into
+    void push(LedFrame& frame) {
+        const auto playAt = schedule(frame.receivedAt);
+        if (playAt < frame.receivedAt) {
+            late++;
+        }
+        if (count == capacity) {
+            first = (first + 1) % capacity;
+            count--;
+            dropped++;
+        }
+        const auto slot = (first + count) % capacity;
+        std::swap(pool[slot], frame);
+        due[slot] = playAt;
+        count++;
+    }
+
+    // false if no frame is due yet. of several due ones, only the newest is given out.
+    bool release(Clock::time_point now, LedFrame& out) {
+        bool any = false;
+        while (count > 0 && due[first] <= now) {
+            if (any) {
+                dropped++;
+            }
+            std::swap(out, pool[first]);
+            first = (first + 1) % capacity;
+            count--;
+            any = true;
+        }
+        if (any) {
+            released++;
+            waited.record(now - out.receivedAt);
+        }
+        return any;
+    }
+
+    // from the panel, takes effect on the next frames, the delay moves there gradually
+    void update(const PlayoutSettings& changed) {
+        settings = changed;
+    }
+
+    [[nodiscard]]
+    PlayoutStats stats() const {
+        return {
+            .delayMillis = delay.count(),
+            .cadenceMillis = cadence.count(),
+            .jitterMillis = jitter.count(),
+            .buffered = count,
+            .released = released,
+            .late = late,
+            .dropped = dropped,
+            .waited = waited.summary(),
+        };
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_PLAYOUTBUFFER_H
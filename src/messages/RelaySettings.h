@@ -0,0 +1,18 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_RELAYSETTINGS_H
+#define DLTROPHY_SIMULATOR_RELAYSETTINGS_H
+
+#include <string>
+#include <vector>
+
+struct RelaySettings {
+    std::vector<int> ports;
+    // <-- what is received on each of these is sent on to the same port of every destination
+    std::vector<std::string> destinations;
+    // <-- "host" or "host:port", the latter only while there is a single port to relay
+};
+
+#endif //DLTROPHY_SIMULATOR_RELAYSETTINGS_H
@@ -0,0 +1,117 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_RGBKERNEL_H
+#define DLTROPHY_SIMULATOR_RGBKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "../LED.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RGB_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+namespace RgbKernel {
+    /*
+     *  Unpacks contiguous R G B R G B ... bytes (DRGB / DNRGB payload) into the LED array,
+     *  i.e. every byte gets widened into its own 32-bit component and the padding is zeroed.
+     *
+     *  The SIMD variants are chosen at runtime, we do not want to require -mavx2 for the whole build.
+     *  Only for GCC / Clang on x86 (also MinGW), everything else takes the scalar loop.
+     */
+
+    static_assert(sizeof(LED) == 4 * sizeof(uint32_t),
+                  "RgbKernel expects LED to be {r, g, b, padding} in 32 bit each");
+
+    inline void unpackScalar(const uint8_t* rgb, LED* leds, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            leds[i].r = rgb[3 * i];
+            leds[i].g = rgb[3 * i + 1];
+            leds[i].b = rgb[3 * i + 2];
+            leds[i]._unusedAlignment = 0;
+        }
+    }
+
+#ifdef RGB_KERNEL_X86
+
+    __attribute__((target("ssse3")))
+    inline void unpackSsse3(const uint8_t* rgb, LED* leds, size_t count) {
+        // one 16-byte load holds 4 LEDs (12 bytes), each shuffle spreads one LED over 16 bytes.
+        const __m128i spread0 = _mm_setr_epi8(0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i spread1 = _mm_setr_epi8(3, -1, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i spread2 = _mm_setr_epi8(6, -1, -1, -1, 7, -1, -1, -1, 8, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i spread3 = _mm_setr_epi8(9, -1, -1, -1, 10, -1, -1, -1, 11, -1, -1, -1, -1, -1, -1, -1);
+        auto* out = reinterpret_cast<__m128i*>(leds);
+        size_t i = 0;
+        // the load reads 4 bytes past the 4 LEDs, so stop while these are still inside the payload
+        for (; i + 5 < count; i += 4) {
+            const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + 3 * i));
+            _mm_storeu_si128(out + i, _mm_shuffle_epi8(src, spread0));
+            _mm_storeu_si128(out + i + 1, _mm_shuffle_epi8(src, spread1));
+            _mm_storeu_si128(out + i + 2, _mm_shuffle_epi8(src, spread2));
+            _mm_storeu_si128(out + i + 3, _mm_shuffle_epi8(src, spread3));
+        }
+        unpackScalar(rgb + 3 * i, leds + i, count - i);
+    }
+
+    __attribute__((target("avx2")))
+    inline void unpackAvx2(const uint8_t* rgb, LED* leds, size_t count) {
+        // same as above, but two LEDs per store (shuffle works per 128-bit lane, so broadcast first)
+        const __m256i spread01 = _mm256_setr_epi8(
+                0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1, -1,
+                3, -1, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i spread23 = _mm256_setr_epi8(
+                6, -1, -1, -1, 7, -1, -1, -1, 8, -1, -1, -1, -1, -1, -1, -1,
+                9, -1, -1, -1, 10, -1, -1, -1, 11, -1, -1, -1, -1, -1, -1, -1);
+        auto* out = reinterpret_cast<__m256i*>(leds);
+        size_t i = 0;
+        for (; i + 5 < count; i += 4) {
+            const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + 3 * i));
+            const __m256i both = _mm256_broadcastsi128_si256(src);
+            _mm256_storeu_si256(out + i / 2, _mm256_shuffle_epi8(both, spread01));
+            _mm256_storeu_si256(out + i / 2 + 1, _mm256_shuffle_epi8(both, spread23));
+        }
+        unpackScalar(rgb + 3 * i, leds + i, count - i);
+    }
+
+#endif
+
+    using UnpackFunction = void (*)(const uint8_t*, LED*, size_t);
+
+    inline UnpackFunction selectUnpack() {
+#ifdef RGB_KERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return unpackAvx2;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            return unpackSsse3;
+        }
+#endif
+        return unpackScalar;
+    }
+
+    inline void unpack(const uint8_t* rgb, LED* leds, size_t count) {
+        static const UnpackFunction function = selectUnpack();
+        function(rgb, leds, count);
+    }
+
+    inline const char* selectedName() {
+        auto function = selectUnpack();
+#ifdef RGB_KERNEL_X86
+        if (function == unpackAvx2) {
+            return "AVX2";
+        }
+        if (function == unpackSsse3) {
+            return "SSSE3";
+        }
+#endif
+        return "scalar";
+    }
+}
+
+#endif //DLTROPHY_SIMULATOR_RGBKERNEL_H
@@ -0,0 +1,191 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_SHAREDFRAMEREADER_H
+#define DLTROPHY_SIMULATOR_SHAREDFRAMEREADER_H
+
+#ifndef _WIN32
+#define HAS_SHARED_FRAME_READER
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SharedFrameRing.h"
+#include "KernelTimestamp.h"
+
+class SharedFrameReader {
+    /*
+     *  The simulator's side of SharedFrameRing.h: maps the producer's segment read-only
+     *  and hands out the newest complete frame, as a span right into the shared memory.
+     *
+     *  Throws if the segment is not there (yet) or does not look like ours,
+     *  the UdpIngest tries again every now and then.
+     */
+
+private:
+    static constexpr int maxAttempts = 4;
+    // <-- a frame that was torn that often in a row means the producer is way faster than us, take the next one
+
+    std::string name;
+    size_t size = 0;
+    const dltrophy_ring_header* ring = nullptr;
+    ino_t inode = 0;
+    uint32_t slots = 0;
+    uint32_t maxLeds = 0;
+    // <-- as validated when mapped, the header lies in memory the producer can still write to
+    std::vector<uint8_t> rgb;
+    // <-- the frame is copied here and only handed out when the producer did not touch it meanwhile
+
+    uint64_t lastPublished = 0;
+
+    size_t frames_ = 0;
+    size_t skippedFrames_ = 0;
+    // <-- the producer was faster than the ingest, not shown
+    size_t tornFrames_ = 0;
+    // <-- only on the ingest thread, it passes them on in its stats
+
+    static uint64_t loadAcquire(const uint64_t& value) {
+        return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
+    }
+
+    [[nodiscard]]
+    const dltrophy_ring_slot* slotAt(uint64_t index) const {
+        return reinterpret_cast<const dltrophy_ring_slot*>(
+            reinterpret_cast<const char*>(ring) + sizeof(dltrophy_ring_header)
+            + (index % slots) * dltrophy_ring_slot_size(maxLeds)
+        );
+    }
+
+public:
+    explicit SharedFrameReader(const std::string& name)
+    : name(name)
+    {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::format("No shared frame ring \"{}\" (yet)", name));
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(dltrophy_ring_header))) {
+            close(fd);
+            throw std::runtime_error(std::format("Shared frame ring \"{}\" is not set up (yet)", name));
+        }
+        size = static_cast<size_t>(info.st_size);
+        inode = info.st_ino;
+        void* memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error(std::format("Cannot map shared frame ring \"{}\"", name));
+        }
+        ring = static_cast<const dltrophy_ring_header*>(memory);
+        slots = ring->slots;
+        maxLeds = ring->maxLeds;
+
+        // dltrophy_ring_size() is for DLTROPHY_RING_SLOTS, any other count might reach beyond the mapping
+        const bool valid = __atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) == DLTROPHY_RING_MAGIC
+                           && ring->version == DLTROPHY_RING_VERSION
+                           && slots == DLTROPHY_RING_SLOTS
+                           && maxLeds <= DLTROPHY_RING_MAX_LEDS
+                           && dltrophy_ring_size(maxLeds) <= size;
+        if (!valid) {
+            munmap(memory, size);
+            throw std::runtime_error(std::format("Shared frame ring \"{}\" is not in our format (version {})",
+                                                 name, DLTROPHY_RING_VERSION));
+        }
+        rgb.resize(3 * static_cast<size_t>(maxLeds));
+        lastPublished = loadAcquire(ring->published);
+        std::cout << "[Shared] Reading frames of up to " << maxLeds << " LEDs from " << name << std::endl;
+    }
+
+    ~SharedFrameReader() {
+        munmap(const_cast<dltrophy_ring_header*>(ring), size);
+        std::cout << "[Shared] Stopped reading from " << name << std::endl;
+    }
+
+    SharedFrameReader(const SharedFrameReader&) = delete;
+    SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+
+    /**
+     *  If the producer completed a frame since the last call, calls
+     *  onFrame(std::span<const uint8_t> rgb) with a copy of the newest one, once it is sure that the producer
+     *  did not overwrite it while it was copied (otherwise it tries the next newest).
+     *  Returns when the producer wrote it, or nullopt if there was nothing (complete).
+     */
+    template <typename OnFrame>
+    std::optional<KernelTime> read(OnFrame&& onFrame) {
+        const auto published = loadAcquire(ring->published);
+        if (published == lastPublished) {
+            return std::nullopt;
+        }
+        if (published > lastPublished) {
+            skippedFrames_ += published - lastPublished - 1;
+        }
+        // <-- otherwise the producer started over in the same segment, nothing was skipped
+        lastPublished = published;
+        if (published == 0) {
+            return std::nullopt;
+        }
+
+        for (int attempt = 0; attempt < maxAttempts; attempt++) {
+            const auto newest = loadAcquire(ring->published);
+            if (newest == 0) {
+                return std::nullopt;
+            }
+            const auto* slot = slotAt(newest - 1);
+            const auto sequence = loadAcquire(slot->sequence);
+            if (sequence % 2 == 0) {
+                const auto nLeds = std::min<size_t>(slot->nLeds, maxLeds);
+                const auto writtenAt = slot->realtimeNs;
+                std::memcpy(rgb.data(), slot + 1, 3 * nLeds);
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == sequence) {
+                    frames_++;
+                    onFrame(std::span<const uint8_t>(rgb.data(), 3 * nLeds));
+                    return KernelTime(std::chrono::duration_cast<KernelTime::duration>(
+                        std::chrono::nanoseconds(writtenAt)
+                    ));
+                }
+            }
+            tornFrames_++;
+        }
+        return std::nullopt;
+    }
+
+    // false if the producer went away or started over with a new segment, then this reader is of no use anymore
+    [[nodiscard]]
+    bool stillCurrent() const {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info{};
+        const bool same = fstat(fd, &info) == 0 && info.st_ino == inode;
+        close(fd);
+        return same;
+    }
+
+    [[nodiscard]]
+    size_t frames() const { return frames_; }
+
+    [[nodiscard]]
+    size_t skippedFrames() const { return skippedFrames_; }
+
+    [[nodiscard]]
+    size_t tornFrames() const { return tornFrames_; }
+};
+
+#endif
+#endif //DLTROPHY_SIMULATOR_SHAREDFRAMEREADER_H
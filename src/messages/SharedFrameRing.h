@@ -0,0 +1,137 @@
+/*
+ *  Shared memory LED frame ring, for local producers (DAW bridge, effect generators, ...)
+ *  that do not want to go through loopback UDP. Plain C (C99 or C++), POSIX shared memory.
+ *  In strict ISO C mode (-std=c99 / -std=c11), define _POSIX_C_SOURCE=200112L or build with -std=gnu99 etc.,
+ *  otherwise the headers leave out what dltrophy_ring_create() needs.
+ *
+ *  The producer creates the segment with dltrophy_ring_create() and writes every frame with
+ *  dltrophy_ring_write(), the simulator maps it read-only (config "sharedFrames": "/name")
+ *  and always shows the newest complete frame.
+ *
+ *  Layout: one dltrophy_ring_header, then DLTROPHY_RING_SLOTS slots of dltrophy_ring_slot_size(maxLeds)
+ *  bytes each, every one a dltrophy_ring_slot followed by maxLeds * 3 bytes of RGB.
+ *  Each slot is guarded by its sequence counter, which is odd while the producer writes it,
+ *  so the reader can tell a torn frame and take it again.
+ *  There must only be one producer per segment.
+ */
+
+#ifndef DLTROPHY_SIMULATOR_SHAREDFRAMERING_H
+#define DLTROPHY_SIMULATOR_SHAREDFRAMERING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DLTROPHY_RING_MAGIC 0x474E5244u
+/* "DRNG", little endian */
+#define DLTROPHY_RING_VERSION 1u
+#define DLTROPHY_RING_SLOTS 4u
+#define DLTROPHY_RING_MAX_LEDS 65536u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t maxLeds;
+    uint64_t published;
+    /* frames completed so far, the newest is in slot (published - 1) % slots */
+    uint64_t reserved[5];
+} dltrophy_ring_header;
+
+typedef struct {
+    uint64_t sequence;
+    uint64_t realtimeNs;
+    /* CLOCK_REALTIME when it was written, for the simulator to measure the handoff */
+    uint32_t nLeds;
+    uint32_t reserved[11];
+} dltrophy_ring_slot;
+
+static inline size_t dltrophy_ring_slot_size(uint32_t maxLeds) {
+    /* cache line aligned, so the slots do not share one */
+    return (sizeof(dltrophy_ring_slot) + 3 * (size_t) maxLeds + 63) & ~(size_t) 63;
+}
+
+static inline size_t dltrophy_ring_size(uint32_t maxLeds) {
+    return sizeof(dltrophy_ring_header) + DLTROPHY_RING_SLOTS * dltrophy_ring_slot_size(maxLeds);
+}
+
+static inline dltrophy_ring_slot* dltrophy_ring_slot_at(const dltrophy_ring_header* ring, uint64_t index) {
+    return (dltrophy_ring_slot*) ((char*) ring + sizeof(dltrophy_ring_header)
+                                  + (index % ring->slots) * dltrophy_ring_slot_size(ring->maxLeds));
+}
+
+static inline uint8_t* dltrophy_ring_rgb(dltrophy_ring_slot* slot) {
+    return (uint8_t*) (slot + 1);
+}
+
+static inline void dltrophy_ring_init(void* memory, uint32_t maxLeds) {
+    dltrophy_ring_header* ring = (dltrophy_ring_header*) memory;
+    memset(memory, 0, dltrophy_ring_size(maxLeds));
+    ring->slots = DLTROPHY_RING_SLOTS;
+    ring->maxLeds = maxLeds;
+    ring->version = DLTROPHY_RING_VERSION;
+    __atomic_store_n(&ring->magic, DLTROPHY_RING_MAGIC, __ATOMIC_RELEASE);
+}
+
+/* rgb holds nLeds RGB triples, anything beyond maxLeds is cut off. */
+static inline void dltrophy_ring_write(dltrophy_ring_header* ring, const uint8_t* rgb, uint32_t nLeds,
+                                       uint64_t realtimeNs) {
+    const uint64_t published = __atomic_load_n(&ring->published, __ATOMIC_RELAXED);
+    dltrophy_ring_slot* slot = dltrophy_ring_slot_at(ring, published);
+    const uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+    if (nLeds > ring->maxLeds) {
+        nLeds = ring->maxLeds;
+    }
+
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dltrophy_ring_rgb(slot), rgb, 3 * (size_t) nLeds);
+    slot->nLeds = nLeds;
+    slot->realtimeNs = realtimeNs;
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&ring->published, published + 1, __ATOMIC_RELEASE);
+}
+
+#ifndef _WIN32
+#if defined(__STRICT_ANSI__) && (!defined(_POSIX_C_SOURCE) || _POSIX_C_SOURCE < 200112L)
+#error "SharedFrameRing.h needs POSIX (shm_open, ftruncate): define _POSIX_C_SOURCE=200112L, or use -std=gnu99 or later"
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* for the producer. name like "/dltrophy", returns NULL on failure (cf. errno). */
+static inline dltrophy_ring_header* dltrophy_ring_create(const char* name, uint32_t maxLeds) {
+    if (maxLeds == 0 || maxLeds > DLTROPHY_RING_MAX_LEDS) {
+        return NULL;
+    }
+    const size_t size = dltrophy_ring_size(maxLeds);
+    shm_unlink(name);
+    /* <-- a fresh segment, so a running reader notices it was replaced */
+    const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t) size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+    dltrophy_ring_init(memory, maxLeds);
+    return (dltrophy_ring_header*) memory;
+}
+
+static inline void dltrophy_ring_destroy(dltrophy_ring_header* ring, const char* name) {
+    munmap(ring, dltrophy_ring_size(ring->maxLeds));
+    shm_unlink(name);
+}
+#endif
+
+#endif /* DLTROPHY_SIMULATOR_SHAREDFRAMERING_H */
@@ -0,0 +1,103 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_SPSCRING_H
+#define DLTROPHY_SIMULATOR_SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/**
+ *  Wait-free ring for exactly one producer thread and exactly one consumer thread.
+ *  The slots are preallocated, the producer copies into them and the consumer copies out,
+ *  i.e. as long as T keeps its capacity on copy-assignment (e.g. std::vector of same size)
+ *  there is no allocation in either direction.
+ *
+ *  Capacity must be a power of two, one slot is always kept free to tell full from empty.
+ */
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing Capacity must be a power of two");
+
+    static constexpr std::size_t mask = Capacity - 1;
+    static constexpr std::size_t cacheLine = 64;
+    // <-- std::hardware_destructive_interference_size is not everywhere yet
+
+    std::array<T, Capacity> slots{};
+    alignas(cacheLine) std::atomic<std::size_t> head{0};
+    // <-- written by the producer only
+    alignas(cacheLine) std::atomic<std::size_t> tail{0};
+    // <-- written by the consumer only
+
+public:
+    SpscRing() = default;
+
+    explicit SpscRing(const T& prototype) {
+        // to give each slot its capacity upfront
+        slots.fill(prototype);
+    }
+
+    // --> producer side
+
+    bool push(const T& value) {
+        const auto h = head.load(std::memory_order_relaxed);
+        const auto next = (h + 1) & mask;
+        if (next == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots[h] = value;
+        head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // --> consumer side
+
+    // swaps as well, cf. popLatest()
+    bool pop(T& out) {
+        const auto t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::swap(out, slots[t]);
+        tail.store((t + 1) & mask, std::memory_order_release);
+        return true;
+    }
+
+    // the entry pop() would take next, without taking it. Stays valid until that pop().
+    [[nodiscard]]
+    const T* front() const {
+        const auto t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[t];
+    }
+
+    // skips everything in between, returns how many entries were dropped that way.
+    // swaps instead of copying, i.e. the slot gets whatever was in out -- the producer overwrites it anyway.
+    std::optional<std::size_t> popLatest(T& out) {
+        const auto t = tail.load(std::memory_order_relaxed);
+        const auto h = head.load(std::memory_order_acquire);
+        if (t == h) {
+            return std::nullopt;
+        }
+        const auto latest = (h + Capacity - 1) & mask;
+        std::swap(out, slots[latest]);
+        tail.store(h, std::memory_order_release);
+        return (h + Capacity - t - 1) & mask;
+    }
+
+    [[nodiscard]]
+    bool empty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() { return Capacity - 1; }
+};
+
+#endif //DLTROPHY_SIMULATOR_SPSCRING_H
@@ -0,0 +1,925 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_UDPINGEST_H
+#define DLTROPHY_SIMULATOR_UDPINGEST_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <variant>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+#include "../LED.h"
+#include "UdpListener.h"
+#include "UdpInterpreter.h"
+#include "DmxInterpreter.h"
+#include "DdpInterpreter.h"
+#include "FrameAssembler.h"
+#include "IngestSource.h"
+#include "UringReceiver.h"
+#include "SharedFrameReader.h"
+#include "RgbKernel.h"
+#include "SpscRing.h"
+#include "LedFrame.h"
+#include "KernelTimestamp.h"
+#include "PacketCapture.h"
+#include "../monitor/LatencyHistogram.h"
+
+enum class UdpBackend {
+    Socket,
+    IoUring,
+    Replay,
+};
+
+struct IngestSettings {
+    int udpPort;
+    size_t nLeds;
+    std::string backend;
+    DmxSettings dmx;
+    int ddpPort;
+    // <-- 0 means: do not listen for DDP
+    std::shared_ptr<CaptureWriter> capture = nullptr;
+    // <-- if set, every received datagram is written there. Owned outside, so restarting the ingest goes on recording
+    std::string replayPath = "";
+    // <-- if set, no socket is opened, the packets come from this capture file instead
+    double replaySpeed = 1;
+    // <-- 1 is as recorded, 0 means as fast as possible
+    std::string frameCommit = "wrap";
+    // <-- when the WLED realtime packets make up a frame, cf. FrameAssembler::ruleFrom()
+    int frameGapMs = 2;
+    // <-- a frame is also committed if nothing came for this long, 0 to wait for the rule only
+    std::vector<int> extraPorts = {};
+    // <-- listened on in addition to udpPort, for the same WLED realtime protocols
+    std::string separateSenders = "address";
+    // <-- which packets get an LED state of their own, cf. IngestSource::separationFrom()
+    std::string sharedFrames = "";
+    // <-- name of a shared memory frame ring (cf. SharedFrameRing.h) to read as well, empty for none
+
+    bool operator==(const IngestSettings& other) const = default;
+};
+
+struct SharedFrameStats {
+    bool attached = false;
+    // <-- false while waiting for the producer
+    size_t frames = 0;
+    size_t skippedFrames = 0;
+    // <-- the producer wrote faster than we read, these were never shown
+    size_t tornFrames = 0;
+    // <-- overwritten while we read them, taken again
+};
+
+struct IngestStats {
+    double packetsPerSecond = 0;
+    double cpuMicrosPerPacket = -1;
+    // <-- negative if the platform can not tell us the thread CPU time
+    LatencySummary arrivalInterval;
+    // <-- between two packets, as stamped by the kernel. its spread is the network jitter
+    LatencySummary receiveToDecode;
+    // <-- from the kernel having it to the LEDs being decoded, i.e. the ingest path
+};
+
+class UdpIngest {
+    /*
+     *  Receives on its own thread, so the render loop does not need to keep up with the sender.
+     *  Every sender (cf. SenderSeparation) gets an IngestSource with its own accumulated frame, which is
+     *  published through its own ring once it is complete (as the protocol says, or the FrameAssembler
+     *  decides for the WLED ones); the render loop takes the newest one of the sender it shows,
+     *  swapping its own buffer in.
+     *  All sockets are waited on together, until a packet comes or a frame gap runs out.
+     */
+
+private:
+    IngestSettings settings;
+    UdpBackend backend = UdpBackend::Socket;
+    SenderSeparation separation;
+
+    std::optional<UdpListener> listener;
+#ifdef HAS_URING_RECEIVER
+    std::optional<UringReceiver> uring;
+#endif
+    std::vector<std::unique_ptr<UdpListener>> extraListeners;
+    // <-- for settings.extraPorts, always plain sockets
+
+    std::optional<UdpListener> sacnListener;
+    std::optional<UdpListener> artNetListener;
+    std::optional<UdpListener> ddpListener;
+
+#ifdef HAS_SHARED_FRAME_READER
+    std::unique_ptr<SharedFrameReader> shared;
+    std::chrono::steady_clock::time_point nextSharedAttempt;
+    bool sharedMissingReported = false;
+    size_t sharedFramesBefore = 0;
+    // <-- at the last stats update, to tell whether the producer is still there
+#endif
+    std::atomic<bool> sharedAttached_{false};
+    std::atomic<size_t> sharedFrames_{0};
+    std::atomic<size_t> sharedSkippedFrames_{0};
+    std::atomic<size_t> sharedTornFrames_{0};
+    static constexpr auto sharedRetryInterval = std::chrono::seconds(1);
+
+#ifdef _WIN32
+    using PollEntry = WSAPOLLFD;
+#else
+    using PollEntry = pollfd;
+#endif
+    std::vector<PollEntry> pollEntries;
+    // <-- filled once all sockets are open
+
+    std::optional<CaptureReader> replay;
+    std::optional<CapturedPacket> replayNext;
+    std::chrono::steady_clock::time_point replayStart;
+    KernelTime replayStartedAt;
+    // <-- the same moment on the clock of the kernel stamps, the recorded times are shifted onto it
+    std::atomic<bool> replayFinished_{false};
+
+    LedFrame scratch;
+    // <-- only on the render thread, to compare the newest frames of several sources
+
+    static constexpr size_t maxSources = 16;
+    std::array<std::unique_ptr<IngestSource>, maxSources> sources;
+    std::atomic<size_t> nSources{0};
+    // <-- the table is only appended to, on the ingest thread. The render thread reads up to this count.
+    IngestSource* lastSource = nullptr;
+    // <-- usually the next packet is from the same sender, then there is nothing to look up
+    std::atomic<size_t> rejectedPackets_{0};
+    // <-- from senders that found the table full
+    std::vector<DmxUniverseMapping> dmxUniverses;
+    // <-- empty if DMX is off, every source gets its own DmxInterpreter on these
+
+    static constexpr size_t maxPacketsPerRound = 64;
+    static constexpr auto idleWait = std::chrono::milliseconds(1);
+    static constexpr auto maxWait = std::chrono::milliseconds(50);
+    // <-- wake up now and then without packets, for the stats and to notice being stopped
+
+    std::thread thread;
+    std::atomic<bool> alive{true};
+    std::atomic<size_t> receivedPackages_{0};
+    std::atomic<size_t> skippedFrames_{0};
+    std::atomic<size_t> droppedFrames_{0};
+    // <-- the ring was full, i.e. the render loop did not take them in time
+
+    static constexpr auto statsInterval = std::chrono::seconds(1);
+    std::chrono::steady_clock::time_point statsSince;
+    size_t statsPackets = 0;
+    std::optional<std::chrono::nanoseconds> statsCpuTime;
+    std::atomic<double> packetsPerSecond_{0};
+    std::atomic<double> cpuMicrosPerPacket_{-1};
+
+    LatencyHistogram arrivalInterval;
+    // <-- over all sources, each measured against its own previous packet
+    LatencyHistogram receiveToDecode;
+    std::atomic<bool> latencyResetRequested{false};
+    // <-- the histograms are only written on the ingest thread, so it does the reset itself
+
+    void run() {
+        statsSince = std::chrono::steady_clock::now();
+        statsCpuTime = threadCpuTime();
+
+        replayStart = statsSince;
+        replayStartedAt = std::chrono::system_clock::now();
+
+        while (alive) {
+            if (replay) {
+                replayRound();
+            } else {
+                receiveRound();
+                readShared();
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const auto n = nSources.load(std::memory_order_relaxed);
+            for (size_t s = 0; s < n; s++) {
+                auto& source = *sources[s];
+                if (source.assembler.timedOut(now)) {
+                    commitFrame(source, true);
+                }
+            }
+
+            updateStats();
+        }
+    }
+
+    void publish(IngestSource& source) {
+        // if the ring is full, the frame is dropped: the back buffer goes on with the next packets right away,
+        // so publishing it later would mix two frames.
+        if (!source.ring.push(source.accumulated)) {
+            droppedFrames_++;
+        }
+        source.accumulated.packets = 0;
+    }
+
+    void commitFrame(IngestSource& source, bool byTimeout = false) {
+        source.assembler.committed(byTimeout);
+        publish(source);
+    }
+
+    IngestSource* sourceFor(const PacketSource& sender, const char* label = nullptr) {
+        const auto key = IngestSource::keyOf(sender, separation);
+        if (lastSource && lastSource->sender == key) {
+            return lastSource;
+        }
+        const auto n = nSources.load(std::memory_order_relaxed);
+        for (size_t s = 0; s < n; s++) {
+            if (sources[s]->sender == key) {
+                return lastSource = sources[s].get();
+            }
+        }
+        if (n == maxSources) {
+            if (rejectedPackets_++ == 0) {
+                std::cerr << "[UdpIngest] More than " << maxSources << " senders, ignoring "
+                          << sender.toString() << " and everyone after" << std::endl;
+            }
+            return nullptr;
+        }
+        // the only allocation on this thread, once per sender
+        sources[n] = std::make_unique<IngestSource>(
+            key, separation == SenderSeparation::None ? nullptr : label, n, settings.nLeds,
+            FrameAssembler::ruleFrom(settings.frameCommit),
+            std::chrono::milliseconds(settings.frameGapMs),
+            settings.ddpPort > 0,
+            dmxUniverses
+        );
+        nSources.store(n + 1, std::memory_order_release);
+        std::cout << "[UdpIngest] New sender " << sources[n]->stats(std::chrono::steady_clock::now()).name()
+                  << " (#" << n << ")" << std::endl;
+        return lastSource = sources[n].get();
+    }
+
+    void receiveRound() {
+        waitForPackets();
+
+        size_t received = 0;
+#ifdef HAS_URING_RECEIVER
+        if (uring) {
+            received += uring->receive(
+                [this](std::span<const uint8_t> payload, const sockaddr_in& sender,
+                       std::optional<KernelTime> receivedAt) {
+                    dispatch(CaptureStream::Wled, payload, UringReceiver::toSource(sender), receivedAt);
+                },
+                std::chrono::milliseconds(0)
+                // <-- the waiting was done in waitForPackets()
+            );
+        }
+#endif
+        if (listener) {
+            received += drain(*listener, [this](const RawMessage& packet) {
+                dispatch(CaptureStream::Wled, packet.bytes, packet.source, packet.receivedAt);
+            });
+        }
+        for (auto& extra : extraListeners) {
+            received += drain(*extra, [this](const RawMessage& packet) {
+                dispatch(CaptureStream::Wled, packet.bytes, packet.source, packet.receivedAt);
+            });
+        }
+        if (sacnListener) {
+            received += drain(*sacnListener, [this](const RawMessage& packet) {
+                dispatch(CaptureStream::Sacn, packet.bytes, packet.source, packet.receivedAt);
+            });
+        }
+        if (artNetListener) {
+            received += drain(*artNetListener, [this](const RawMessage& packet) {
+                dispatch(CaptureStream::ArtNet, packet.bytes, packet.source, packet.receivedAt);
+            });
+        }
+        if (ddpListener) {
+            received += drain(*ddpListener, [this](const RawMessage& packet) {
+                dispatch(CaptureStream::Ddp, packet.bytes, packet.source, packet.receivedAt);
+            });
+        }
+        receivedPackages_ += received;
+    }
+
+    void waitForPackets() {
+        // one wait for all sockets. It ends early for the next frame gap.
+        const auto now = std::chrono::steady_clock::now();
+        auto wakeUp = now + maxWait;
+        const auto n = nSources.load(std::memory_order_relaxed);
+        for (size_t s = 0; s < n; s++) {
+            const auto& source = *sources[s];
+            if (auto deadline = source.assembler.deadline()) {
+                wakeUp = std::min(wakeUp, *deadline);
+            }
+        }
+#ifdef HAS_SHARED_FRAME_READER
+        if (shared) {
+            // shared memory can not be waited on together with the sockets, so look at it often
+            wakeUp = std::min(wakeUp, now + idleWait);
+        }
+#endif
+        const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(std::max(wakeUp - now, std::chrono::steady_clock::duration::zero()));
+
+        if (pollEntries.empty()) {
+            // e.g. if none of the ports could be opened
+            std::this_thread::sleep_for(timeout);
+            return;
+        }
+        for (auto& entry : pollEntries) {
+            entry.revents = 0;
+        }
+#ifdef _WIN32
+        WSAPoll(pollEntries.data(), static_cast<ULONG>(pollEntries.size()), static_cast<INT>(timeout.count()));
+#else
+        ::poll(pollEntries.data(), pollEntries.size(), static_cast<int>(timeout.count()));
+#endif
+        // <-- errors (EINTR) are no different from a timeout, we look at all sockets anyway
+    }
+
+    template <typename Handle>
+    void waitOn(Handle handle) {
+        pollEntries.push_back(PollEntry{.fd = handle, .events = POLLIN});
+    }
+
+    void collectPollEntries() {
+#ifdef HAS_URING_RECEIVER
+        if (uring) {
+            waitOn(uring->pollHandle());
+        }
+#endif
+        if (listener) {
+            waitOn(listener->handle());
+        }
+        for (auto& extra : extraListeners) {
+            waitOn(extra->handle());
+        }
+        for (auto* other : {&sacnListener, &artNetListener, &ddpListener}) {
+            if (*other) {
+                waitOn((*other)->handle());
+            }
+        }
+    }
+
+    void readShared() {
+#ifdef HAS_SHARED_FRAME_READER
+        if (settings.sharedFrames.empty()) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (!shared) {
+            if (now < nextSharedAttempt) {
+                return;
+            }
+            nextSharedAttempt = now + sharedRetryInterval;
+            try {
+                shared = std::make_unique<SharedFrameReader>(settings.sharedFrames);
+                sharedAttached_ = true;
+                sharedMissingReported = false;
+                sharedFramesBefore = 0;
+            } catch (const std::exception& e) {
+                if (!sharedMissingReported) {
+                    std::cout << "[Shared] " << e.what() << ", waiting for the producer" << std::endl;
+                    sharedMissingReported = true;
+                }
+                return;
+            }
+        }
+
+        IngestSource* source = nullptr;
+        const auto writtenAt = shared->read([this, &source](std::span<const uint8_t> rgb) {
+            source = source ? source : sourceFor(PacketSource{}, "shared memory");
+            if (!source) {
+                return;
+            }
+            // nothing to interpret, the reader only hands out frames that were not torn, so they go right into the back buffer
+            auto& leds = source->accumulated.leds;
+            RgbKernel::unpack(rgb.data(), leds.data(), std::min(rgb.size() / 3, leds.size()));
+        });
+        if (!writtenAt || !source) {
+            return;
+        }
+        source->received(now);
+        source->accumulated.packets++;
+        source->accumulated.receivedAt = KernelTimestamp::onSteadyClock(writtenAt);
+        source->accumulated.decodedAt = std::chrono::steady_clock::now();
+        publish(*source);
+        measure(*source, writtenAt);
+        receivedPackages_++;
+#endif
+    }
+
+    void checkShared() {
+        // once per stats interval. A producer that stopped sending might have started over with a new segment.
+#ifdef HAS_SHARED_FRAME_READER
+        if (!shared) {
+            return;
+        }
+        const auto frames = shared->frames();
+        sharedFrames_ = frames;
+        sharedSkippedFrames_ = shared->skippedFrames();
+        sharedTornFrames_ = shared->tornFrames();
+        if (frames == sharedFramesBefore && !shared->stillCurrent()) {
+            shared.reset();
+            sharedAttached_ = false;
+            nextSharedAttempt = {};
+        }
+        sharedFramesBefore = frames;
+#endif
+    }
+
+    void replayRound() {
+        if (replayFinished_) {
+            std::this_thread::sleep_for(maxWait);
+            return;
+        }
+        size_t replayed = 0;
+        while (replayed < maxPacketsPerRound) {
+            if (!replayNext) {
+                replayNext = replay->next();
+                if (!replayNext) {
+                    finishReplay();
+                    break;
+                }
+            }
+            // as if it arrived when it is due, i.e. as recorded (at the replay speed). As fast as it gets,
+            // there is nothing like an arrival, then these packets stay out of the latency stats.
+            std::optional<KernelTime> receivedAt;
+            if (settings.replaySpeed > 0) {
+                const auto sinceStart = replayNext->at / settings.replaySpeed;
+                const auto due = replayStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    sinceStart
+                );
+                const auto now = std::chrono::steady_clock::now();
+                if (due > now) {
+                    if (replayed == 0) {
+                        std::this_thread::sleep_until(std::min(due, now + idleWait));
+                    }
+                    break;
+                }
+                receivedAt = replayStartedAt + std::chrono::duration_cast<KernelTime::duration>(sinceStart);
+            }
+            dispatch(replayNext->stream, replayNext->bytes, replayNext->source, receivedAt);
+            replayNext.reset();
+            replayed++;
+            receivedPackages_++;
+        }
+    }
+
+    void finishReplay() {
+        replayFinished_ = true;
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+        std::cout << "[Replay] " << replay->filename() << ": " << receivedPackages_ << " packets in "
+                  << seconds << " s (" << static_cast<double>(receivedPackages_) / seconds << " packets/s)"
+                  << std::endl;
+    }
+
+    void dispatch(CaptureStream stream, std::span<const uint8_t> bytes, const PacketSource& sender,
+                  const std::optional<KernelTime>& receivedAt) {
+        if (settings.capture) {
+            settings.capture->write(stream, sender, bytes);
+        }
+        auto* source = sourceFor(sender);
+        if (!source) {
+            return;
+        }
+        source->received(std::chrono::steady_clock::now());
+        source->arrivedAt = KernelTimestamp::onSteadyClock(receivedAt);
+        switch (stream) {
+            case CaptureStream::Wled:
+                apply(*source, bytes, sender);
+                break;
+            case CaptureStream::Sacn:
+            case CaptureStream::ArtNet:
+                if (!source->dmx) {
+                    return;
+                }
+                applyDmx(*source, stream == CaptureStream::Sacn ? DmxProtocol::Sacn : DmxProtocol::ArtNet, bytes);
+                break;
+            case CaptureStream::Ddp:
+                if (!source->ddp) {
+                    return;
+                }
+                applyDdp(*source, bytes);
+                break;
+            default:
+                return;
+        }
+        measure(*source, receivedAt);
+    }
+
+    template <typename OnPacket>
+    static size_t drain(UdpListener& from, OnPacket&& onPacket) {
+        size_t received = 0;
+        while (received < maxPacketsPerRound) {
+            auto packet = from.listen();
+            if (!packet.has_value()) {
+                break;
+            }
+            onPacket(*packet);
+            received++;
+        }
+        return received;
+    }
+
+    void applyDmx(IngestSource& source, DmxProtocol protocol, std::span<const uint8_t> bytes) {
+        auto& frame = source.accumulated;
+        frame.packets++;
+        // a completed frame goes out right away, before the next one is written over it
+        source.dmx->interpret(protocol, bytes, frame.leds, [this, &source] {
+            source.accumulated.receivedAt = source.arrivedAt;
+            source.accumulated.decodedAt = std::chrono::steady_clock::now();
+            publish(source);
+        });
+    }
+
+    void apply(IngestSource& source, std::span<const uint8_t> bytes, const PacketSource& sender) {
+        // decodes right into the accumulated frame, nothing in here allocates per packet.
+        if (source.assembler.startsNewFrame(bytes)) {
+            commitFrame(source);
+        }
+        auto message = UdpInterpreter::interpret(bytes, sender, source.accumulated.leds, &source.delta);
+
+        std::visit([this, &source](auto&& msg) {
+            using T = std::decay_t<decltype(msg)>;
+
+            if constexpr (std::is_same_v<T, ProtocolMessage>) {
+                auto& frame = source.accumulated;
+                frame.lastMessage = msg;
+                frame.packets++;
+                frame.receivedAt = source.arrivedAt;
+                frame.decodedAt = std::chrono::steady_clock::now();
+                if (source.assembler.completes(msg)) {
+                    commitFrame(source);
+                }
+
+            } else if constexpr (std::is_same_v<T, UnreadableMessage>) {
+                if (verbose) {
+                    msg.printDebug(std::cout);
+                }
+            }
+
+        }, message);
+    }
+
+    void applyDdp(IngestSource& source, std::span<const uint8_t> bytes) {
+        source.accumulated.packets++;
+        source.ddp->interpret(bytes, [this, &source](std::span<const LED> frame) {
+            std::copy(frame.begin(), frame.end(), source.accumulated.leds.begin());
+            source.accumulated.receivedAt = source.arrivedAt;
+            source.accumulated.decodedAt = std::chrono::steady_clock::now();
+            publish(source);
+        });
+    }
+
+    void measure(IngestSource& source, const std::optional<KernelTime>& receivedAt) {
+        // after the decoding, so that is included. Without the kernel's stamp there is nothing to compare to.
+        if (!receivedAt) {
+            return;
+        }
+        receiveToDecode.record(std::chrono::system_clock::now() - *receivedAt);
+        if (source.lastArrival) {
+            arrivalInterval.record(*receivedAt - *source.lastArrival);
+        }
+        source.lastArrival = receivedAt;
+    }
+
+    void updateStats() {
+        const auto n = nSources.load(std::memory_order_relaxed);
+        if (latencyResetRequested.exchange(false)) {
+            arrivalInterval.reset();
+            receiveToDecode.reset();
+            for (size_t s = 0; s < n; s++) {
+                sources[s]->lastArrival.reset();
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = now - statsSince;
+        if (elapsed < statsInterval) {
+            return;
+        }
+        auto packets = receivedPackages_.load();
+        auto newPackets = packets - statsPackets;
+        auto seconds = std::chrono::duration<double>(elapsed).count();
+        packetsPerSecond_ = static_cast<double>(newPackets) / seconds;
+
+        for (size_t s = 0; s < n; s++) {
+            auto& source = *sources[s];
+            const auto sourcePackets = source.packets.load();
+            source.packetsPerSecond = static_cast<double>(sourcePackets - source.statsPackets) / seconds;
+            source.statsPackets = sourcePackets;
+        }
+
+        auto cpuTime = threadCpuTime();
+        if (cpuTime && statsCpuTime && newPackets > 0) {
+            auto cpuMicros = std::chrono::duration<double, std::micro>(*cpuTime - *statsCpuTime).count();
+            cpuMicrosPerPacket_ = cpuMicros / static_cast<double>(newPackets);
+        } else {
+            cpuMicrosPerPacket_ = -1;
+        }
+
+        statsSince = now;
+        statsPackets = packets;
+        statsCpuTime = cpuTime;
+
+        checkShared();
+    }
+
+    static std::optional<std::chrono::nanoseconds> threadCpuTime() {
+#ifdef __linux__
+        timespec ts{};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+            return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+        }
+#endif
+        return std::nullopt;
+    }
+
+    void openBackend() {
+        if (!settings.replayPath.empty()) {
+            try {
+                replay.emplace(settings.replayPath);
+                backend = UdpBackend::Replay;
+                std::cout << "[Replay] Replaying " << settings.replayPath << " instead of listening" << std::endl;
+                return;
+            } catch (const std::exception& e) {
+                std::cerr << "[Replay] " << e.what() << " -- listening on the sockets instead." << std::endl;
+            }
+        }
+        openExtraPorts();
+        if (backendFrom(settings.backend) == UdpBackend::IoUring) {
+#ifdef HAS_URING_RECEIVER
+            try {
+                uring.emplace(settings.udpPort);
+                backend = UdpBackend::IoUring;
+                return;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << " -- falling back to the plain socket." << std::endl;
+            }
+#else
+            std::cerr << "[UdpIngest] io_uring is only available on Linux, falling back to the plain socket."
+                      << std::endl;
+#endif
+        }
+        listener.emplace(settings.udpPort);
+        backend = UdpBackend::Socket;
+    }
+
+    void openExtraPorts() {
+        for (auto port : settings.extraPorts) {
+            if (port <= 0 || port == settings.udpPort) {
+                continue;
+            }
+            try {
+                extraListeners.push_back(std::make_unique<UdpListener>(port));
+            } catch (const std::exception& e) {
+                std::cerr << "[UdpIngest] " << e.what() << std::endl;
+            }
+        }
+    }
+
+    void openDmx() {
+        if (!settings.dmx.enabled()) {
+            return;
+        }
+        dmxUniverses = settings.dmx.universes;
+        if (replay) {
+            return;
+        }
+        try {
+            if (settings.dmx.sacn) {
+                sacnListener.emplace(DmxInterpreter::sacnPort);
+                for (auto universe : DmxInterpreter(dmxUniverses).universes()) {
+                    sacnListener->joinMulticast(DmxInterpreter::sacnMulticastGroup(universe));
+                }
+            }
+            if (settings.dmx.artNet) {
+                artNetListener.emplace(DmxInterpreter::artNetPort);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[DMX] " << e.what() << std::endl;
+        }
+    }
+
+    void openDdp() {
+        if (settings.ddpPort <= 0 || replay) {
+            return;
+        }
+        try {
+            ddpListener.emplace(settings.ddpPort);
+        } catch (const std::exception& e) {
+            std::cerr << "[DDP] " << e.what() << std::endl;
+        }
+    }
+
+    template <typename Stats, typename Of>
+    Stats sumOver(Of&& of) const {
+        Stats sum{};
+        const auto n = nSources.load(std::memory_order_acquire);
+        for (size_t s = 0; s < n; s++) {
+            of(sum, *sources[s]);
+        }
+        return sum;
+    }
+
+public:
+    std::atomic<bool> verbose{false};
+
+    explicit UdpIngest(const IngestSettings& settings)
+    : settings(settings),
+      separation(IngestSource::separationFrom(settings.separateSenders)),
+      scratch{.leds = std::vector<LED>(settings.nLeds)}
+    {
+        openBackend();
+        openDmx();
+        openDdp();
+        collectPollEntries();
+        thread = std::thread([this] { this->run(); });
+    }
+
+    ~UdpIngest() {
+        alive = false;
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    // only from the render thread. returns false if nothing new arrived (from that source, if given).
+    bool takeLatest(LedFrame& frame, std::optional<size_t> onlySource = std::nullopt) {
+        bool taken = false;
+        const auto n = nSources.load(std::memory_order_acquire);
+        for (size_t s = 0; s < n; s++) {
+            auto& ring = sources[s]->ring;
+            if (onlySource && s != *onlySource) {
+                // <-- not shown, but must not back up
+                while (ring.pop(scratch)) {}
+                continue;
+            }
+            const auto skipped = ring.popLatest(scratch);
+            if (!skipped) {
+                continue;
+            }
+            skippedFrames_ += *skipped;
+            // without a source given, whoever sent last wins
+            if (!taken || scratch.decodedAt >= frame.decodedAt) {
+                std::swap(frame, scratch);
+            }
+            if (taken) {
+                skippedFrames_++;
+            }
+            taken = true;
+        }
+        return taken;
+    }
+
+    // only from the render thread, while it shows something else, so that the senders do not back up
+    void discardFrames() {
+        const auto n = nSources.load(std::memory_order_acquire);
+        for (size_t s = 0; s < n; s++) {
+            while (sources[s]->ring.pop(scratch)) {
+                skippedFrames_++;
+            }
+        }
+    }
+
+    // only from the render thread, in order, for the PlayoutBuffer. returns false if nothing is left.
+    bool takeNext(LedFrame& frame, std::optional<size_t> onlySource = std::nullopt) {
+        const auto n = nSources.load(std::memory_order_acquire);
+        SpscRing<LedFrame, IngestSource::ringSize>* oldest = nullptr;
+        for (size_t s = 0; s < n; s++) {
+            auto& ring = sources[s]->ring;
+            if (onlySource && s != *onlySource) {
+                while (ring.pop(scratch)) {}
+                continue;
+            }
+            const auto* next = ring.front();
+            if (next && (!oldest || next->decodedAt < oldest->front()->decodedAt)) {
+                oldest = &ring;
+            }
+        }
+        return oldest && oldest->pop(frame);
+    }
+
+    bool runsWith(const IngestSettings& other) const {
+        return settings == other;
+    }
+
+    static UdpBackend backendFrom(const std::string& name) {
+        return name == "io_uring"
+            ? UdpBackend::IoUring
+            : UdpBackend::Socket;
+    }
+
+    [[nodiscard]]
+    const char* backendName() const {
+        switch (backend) {
+            case UdpBackend::IoUring:
+                return "io_uring";
+            case UdpBackend::Replay:
+                return "replay";
+            default:
+                return "socket";
+        }
+    }
+
+    [[nodiscard]]
+    bool replayFinished() const { return replayFinished_.load(); }
+
+    [[nodiscard]]
+    IngestStats stats() const {
+        return {
+            .packetsPerSecond = packetsPerSecond_.load(),
+            .cpuMicrosPerPacket = cpuMicrosPerPacket_.load(),
+            .arrivalInterval = arrivalInterval.summary(),
+            .receiveToDecode = receiveToDecode.summary(),
+        };
+    }
+
+    void resetLatencies() {
+        latencyResetRequested = true;
+    }
+
+    [[nodiscard]]
+    size_t receivedPackages() const { return receivedPackages_.load(); }
+
+    [[nodiscard]]
+    size_t skippedFrames() const { return skippedFrames_.load(); }
+
+    [[nodiscard]]
+    size_t droppedFrames() const { return droppedFrames_.load(); }
+
+    [[nodiscard]]
+    size_t rejectedPackets() const { return rejectedPackets_.load(); }
+
+    // cut off at the buffer size, these are not decoded. The listeners are all opened in the constructor.
+    [[nodiscard]]
+    size_t truncatedPackets() const {
+        size_t result = 0;
+        for (const auto* socket : {&listener, &sacnListener, &artNetListener, &ddpListener}) {
+            if (*socket) {
+                result += (*socket)->truncatedPackages();
+            }
+        }
+        for (const auto& extra : extraListeners) {
+            result += extra->truncatedPackages();
+        }
+#ifdef HAS_URING_RECEIVER
+        if (uring) {
+            result += uring->truncatedPackages();
+        }
+#endif
+        return result;
+    }
+
+    [[nodiscard]]
+    std::optional<SharedFrameStats> sharedStats() const {
+        if (settings.sharedFrames.empty() || replay) {
+            return std::nullopt;
+        }
+        return SharedFrameStats{
+            .attached = sharedAttached_.load(),
+            .frames = sharedFrames_.load(),
+            .skippedFrames = sharedSkippedFrames_.load(),
+            .tornFrames = sharedTornFrames_.load(),
+        };
+    }
+
+    [[nodiscard]]
+    size_t sourceCount() const { return nSources.load(std::memory_order_acquire); }
+
+    // index as in LedFrame::source, below sourceCount()
+    [[nodiscard]]
+    SourceStats sourceStats(size_t index) const {
+        return sources[index]->stats(std::chrono::steady_clock::now());
+    }
+
+    [[nodiscard]]
+    FrameAssemblyStats frameStats() const {
+        return sumOver<FrameAssemblyStats>([](auto& sum, const IngestSource& source) {
+            sum += source.assembler.stats();
+        });
+    }
+
+    [[nodiscard]]
+    std::optional<DmxStats> dmxStats() const {
+        if (dmxUniverses.empty()) {
+            return std::nullopt;
+        }
+        return sumOver<DmxStats>([](auto& sum, const IngestSource& source) {
+            if (source.dmx) {
+                sum += source.dmx->stats();
+            }
+        });
+    }
+
+    [[nodiscard]]
+    std::optional<DdpStats> ddpStats() const {
+        if (settings.ddpPort <= 0) {
+            return std::nullopt;
+        }
+        return sumOver<DdpStats>([](auto& sum, const IngestSource& source) {
+            if (source.ddp) {
+                sum += source.ddp->stats();
+            }
+        });
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_UDPINGEST_H
@@ -5,13 +5,16 @@
 #ifndef DLTROPHY_SIMULATOR_UDPINTERPRETER_H
 #define DLTROPHY_SIMULATOR_UDPINTERPRETER_H
 
-#include <map>
+#include <algorithm>
 #include <optional>
 #include <format>
 #include <ctime>
+#include <span>
+#include <variant>
 
 #include "../LED.h"
-#include "UdpListener.h"
+#include "PacketSource.h"
+#include "RgbKernel.h"
 #include "timeFormat.h"
 
 enum class RealtimeProtocol {
@@ -24,117 +27,250 @@ enum class RealtimeProtocol {
     // DRGBW: not implemented because of too little sense
     // DNRGB: <2 header bytes> <2 start index bytes>; R G B R G B ...
     DNRGB,
+    // Delta: not WLED's, for our WLEDline fork. <2 header bytes> <flags> <sequence>; runs, cf. interpretDelta()
+    Delta,
+};
+
+struct DeltaState {
+    // per sender, as every delta frame builds on the frame before it
+    std::optional<uint8_t> sequence;
+    // <-- of the frame last applied, nothing before the first keyframe or after one got lost
 };
 
 struct ProtocolMessage {
+    // what was written where -- the colors themselves went straight into the LED array.
     RealtimeProtocol protocol;
     std::optional<int> timeoutSec;
-    std::unordered_map<uint8_t, LED> mapping;
-    std::string source;
+    LedIndex firstIndex = 0;
+    LedIndex lastIndex = 0;
+    size_t ledCount = 0;
+    size_t ignoredLeds = 0;
+    // <-- addressed beyond the LEDs we have
+    PacketSource source;
     std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
 };
 
 struct UnreadableMessage {
-    std::string reason;
-    RawMessage original;
+    const char* reason;
+    int detail = 0;
+    size_t size = 0;
+    PacketSource source;
     std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
 
     void printDebug(std::ostream& os) const {
         os << "[UDP MESSAGE][" << formatTime(timestamp)
            << "] Unreadable. " << reason
+           << " (" << detail << ", " << size << " bytes from " << source.toString() << ")"
            << std::endl;
     }
 };
 
-struct IndexStride{
-    size_t step;
-    size_t start;
-};
-
-const std::unordered_map<RealtimeProtocol, IndexStride> protocolStride{
-        {RealtimeProtocol::WARLS, {4, 2}},
-        {RealtimeProtocol::DRGB, {3, 2}},
-        {RealtimeProtocol::DNRGB, {3, 4}},
-};
-
 using AnyMessage = std::variant<ProtocolMessage, UnreadableMessage>;
 
 class UdpInterpreter {
+    /*
+     *  Decodes one datagram straight into the given LED array, without any allocation
+     *  (the strings of an UnreadableMessage are only ever built when printed).
+     */
+
 public:
 
-    static AnyMessage interpret(const RawMessage& message) {
-        auto maybeResult = interpretHeader(message);
-        if (std::holds_alternative<UnreadableMessage>(maybeResult)) {
-            return maybeResult;
+    static constexpr uint8_t deltaHeader = 200;
+    static constexpr uint8_t deltaKeyframe = 0x01;
+    static constexpr uint8_t deltaSkip = 0x80;
+    // <-- run control byte: with this bit, (c & 0x7f) + 1 LEDs are unchanged, otherwise c + 1 LEDs follow
+    static constexpr size_t maxRunLength = 128;
+
+    // without a DeltaState, every delta frame is applied as if none got lost
+    static AnyMessage interpret(std::span<const uint8_t> bytes,
+                                const PacketSource& source,
+                                std::span<LED> leds,
+                                DeltaState* delta = nullptr) {
+        if (bytes.size() < 2) {
+            return UnreadableMessage{"Message too short (needs 2 header bytes)", 0, bytes.size(), source};
         }
-        auto result = std::get<ProtocolMessage>(maybeResult);
-        auto stride = protocolStride.at(result.protocol);
-        size_t ledIndex;
-        LED led;
-
-        for (size_t i = stride.start; i < message.values.size(); i += stride.step) {
-
-            switch (result.protocol) {
-
-                case RealtimeProtocol::WARLS:
-                    ledIndex = message.values[i];
-                    led = LED::from(message.values, i+1);
-                    break;
-
-                case RealtimeProtocol::DRGB:
-                    ledIndex = (i - stride.start) / stride.step;
-                    led = LED::from(message.values, i);
-                    break;
-
-                case RealtimeProtocol::DNRGB:
-                    ledIndex = (i - stride.start) / stride.step
-                            + int16from(message.values[2], message.values[3]);
-                    led = LED::from(message.values, i);
-                    break;
-
-                default:
-                    // actually handled above already, but just to be sure.
-                    return UnreadableMessage{"Invalid Protocol", message};
-            }
 
-            result.mapping[ledIndex] = led;
+        auto protocol = asProtocol(bytes[0]);
+        if (!protocol) {
+            return UnreadableMessage{"Unsupported Protocol", bytes[0], bytes.size(), source};
+        }
+
+        std::optional<int> timeoutSec = bytes[1];
+        if (timeoutSec >= 255) {
+            // 255 is the value WLED actually sends for "no timeout"
+            timeoutSec = std::nullopt;
+        }
+
+        ProtocolMessage result{
+            .protocol = *protocol,
+            .timeoutSec = timeoutSec,
+            .source = source,
+        };
+
+        switch (*protocol) {
+            case RealtimeProtocol::WARLS:
+                interpretWarls(bytes.subspan(2), leds, result);
+                break;
+
+            case RealtimeProtocol::DRGB:
+                interpretContiguous(bytes.subspan(2), 0, leds, result);
+                break;
+
+            case RealtimeProtocol::DNRGB:
+                if (bytes.size() < 4) {
+                    return UnreadableMessage{"DNRGB needs 2 start index bytes", 0, bytes.size(), source};
+                }
+                interpretContiguous(bytes.subspan(4), int16from(bytes[2], bytes[3]), leds, result);
+                break;
+
+            case RealtimeProtocol::Delta:
+                if (bytes.size() < 4) {
+                    return UnreadableMessage{"Delta needs flags and sequence bytes", 0, bytes.size(), source};
+                }
+                if (auto failure = interpretDelta(bytes, leds, delta, result)) {
+                    return *failure;
+                }
+                break;
         }
 
         return result;
     }
 
-    static uint16_t int16from(uint8_t highByte, uint8_t lowByte) {
-        return (static_cast<uint16_t>(highByte) << 8) | lowByte;
+    // where the packet is going to write, without decoding it. nullopt if it is not one of ours.
+    static std::optional<LedIndex> startIndex(std::span<const uint8_t> bytes) {
+        if (bytes.size() < 2) {
+            return std::nullopt;
+        }
+        switch (bytes[0]) {
+            case 1:
+                if (bytes.size() < 3) {
+                    return std::nullopt;
+                }
+                return bytes[2];
+            case 2:
+            case deltaHeader:
+                return 0;
+            case 4:
+                if (bytes.size() < 4) {
+                    return std::nullopt;
+                }
+                return int16from(bytes[2], bytes[3]);
+            default:
+                return std::nullopt;
+        }
+    }
+
+    static LedIndex int16from(uint8_t highByte, uint8_t lowByte) {
+        return static_cast<LedIndex>((highByte << 8) | lowByte);
     }
 
 private:
-    static std::variant<ProtocolMessage, UnreadableMessage> interpretHeader(const RawMessage& message) {
-        if (message.values.size() < 2) {
-            return UnreadableMessage{"Message too short (needs 2 header bytes)", message};
+    static void interpretWarls(std::span<const uint8_t> payload,
+                               std::span<LED> leds,
+                               ProtocolMessage& result) {
+        // INDEX R G B INDEX R G B ... (incomplete quadruples at the end are ignored)
+        // the index is only one byte here, use DNRGB for anything beyond LED 255.
+        result.firstIndex = UINT8_MAX;
+        for (size_t i = 0; i + 4 <= payload.size(); i += 4) {
+            const LedIndex index = payload[i];
+            if (index >= leds.size()) {
+                result.ignoredLeds++;
+                continue;
+            }
+            leds[index] = LED(payload[i + 1], payload[i + 2], payload[i + 3]);
+            result.firstIndex = std::min(result.firstIndex, index);
+            result.lastIndex = std::max(result.lastIndex, index);
+            result.ledCount++;
+        }
+        if (result.ledCount == 0) {
+            result.firstIndex = 0;
         }
+    }
 
-        int protocolIndex = message.values[0];
-        std::optional<int> timeoutSec = message.values[1];
+    static void interpretContiguous(std::span<const uint8_t> payload,
+                                    LedIndex startIndex,
+                                    std::span<LED> leds,
+                                    ProtocolMessage& result) {
+        // R G B R G B ... from startIndex on, goes through the SIMD kernel.
+        const size_t given = payload.size() / 3;
+        const size_t fitting = startIndex < leds.size()
+                               ? std::min(given, leds.size() - startIndex)
+                               : 0;
+        RgbKernel::unpack(payload.data(), leds.data() + startIndex, fitting);
 
-        auto protocol = asProtocol(protocolIndex);
-        if (!protocol) {
-            return UnreadableMessage{
-                    std::format("Unsupported Protocol: {}", protocolIndex),
-                    message
-            };
+        result.firstIndex = startIndex;
+        result.lastIndex = static_cast<LedIndex>(fitting > 0 ? startIndex + fitting - 1 : startIndex);
+        result.ledCount = fitting;
+        result.ignoredLeds = given - fitting;
+    }
+
+    static std::optional<UnreadableMessage> interpretDelta(std::span<const uint8_t> bytes,
+                                                           std::span<LED> leds,
+                                                           DeltaState* delta,
+                                                           ProtocolMessage& result) {
+        // Always a whole frame from LED 0 on, as runs of LEDs that are the same as in the previous frame
+        // and of LEDs that changed, given as R G B XORed onto the previous frame.
+        // A keyframe (flags & 0x01) is the same against an all black frame, i.e. plain R G B.
+        // LEDs after the last run stay as they are.
+        const bool keyframe = bytes[2] & deltaKeyframe;
+        const uint8_t sequence = bytes[3];
+        const auto runs = bytes.subspan(4);
+
+        if (!keyframe && delta && delta->sequence != static_cast<uint8_t>(sequence - 1)) {
+            // the frame this one builds on did not arrive, wait for the next keyframe instead of showing garbage
+            delta->sequence.reset();
+            return UnreadableMessage{"Delta frame without its previous one", sequence, bytes.size(), result.source};
         }
 
-        if (timeoutSec < 0 || timeoutSec >= 255) {
-            // 255 is the value WLED actually sends for "no timeout"
-            timeoutSec = std::nullopt;
+        // check first, so that a broken packet does not leave half of it in the LEDs
+        size_t length = 0;
+        for (size_t at = 0; at < runs.size();) {
+            const uint8_t control = runs[at++];
+            const size_t count = (control & ~deltaSkip) + 1;
+            if (!(control & deltaSkip)) {
+                if (at + 3 * count > runs.size()) {
+                    return UnreadableMessage{"Delta run is cut off at LED", static_cast<int>(length),
+                                             bytes.size(), result.source};
+                }
+                at += 3 * count;
+            }
+            length += count;
+        }
+        if (delta) {
+            delta->sequence = sequence;
         }
 
-        return ProtocolMessage{
-            .protocol = *protocol,
-            .timeoutSec = timeoutSec,
-            .mapping = {},
-            .source = message.source,
-        };
+        size_t index = 0;
+        for (size_t at = 0; at < runs.size() && index < leds.size();) {
+            const uint8_t control = runs[at++];
+            const size_t count = (control & ~deltaSkip) + 1;
+            const size_t fitting = std::min(count, leds.size() - index);
+            if (control & deltaSkip) {
+                if (keyframe) {
+                    std::fill_n(leds.begin() + index, fitting, LED());
+                }
+            } else if (keyframe) {
+                RgbKernel::unpack(runs.data() + at, leds.data() + index, fitting);
+                at += 3 * count;
+            } else {
+                const uint8_t* rgb = runs.data() + at;
+                for (size_t i = 0; i < fitting; i++) {
+                    auto& led = leds[index + i];
+                    led.r ^= rgb[3 * i];
+                    led.g ^= rgb[3 * i + 1];
+                    led.b ^= rgb[3 * i + 2];
+                }
+                at += 3 * count;
+            }
+            index += count;
+        }
+
+        // what the runs did not touch is as it was, so the frame is complete in any case
+        result.firstIndex = 0;
+        result.lastIndex = static_cast<LedIndex>(leds.empty() ? 0 : leds.size() - 1);
+        result.ledCount = leds.size();
+        result.ignoredLeds = length > leds.size() ? length - leds.size() : 0;
+        return std::nullopt;
     }
 
     static std::optional<RealtimeProtocol> asProtocol(uint8_t number) {
@@ -145,6 +281,8 @@ private:
                 return RealtimeProtocol::DRGB;
             case 4:
                 return RealtimeProtocol::DNRGB;
+            case deltaHeader:
+                return RealtimeProtocol::Delta;
             default:
                 return std::nullopt;
         }
@@ -5,12 +5,30 @@
 #ifndef DLTROPHY_SIMULATOR_UDPLISTENER_H
 #define DLTROPHY_SIMULATOR_UDPLISTENER_H
 
+#include <algorithm>
 #include <iostream>
+#include <atomic>
+#include <array>
+#include <span>
 #include "MinimalSocket/udp/UdpSocket.h"
+#include "PacketSource.h"
+#include "KernelTimestamp.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
 
 struct RawMessage {
-    std::vector<int> values;
-    std::string source;
+    std::span<const uint8_t> bytes;
+    // <-- only valid until the next listen()
+    PacketSource source;
+    std::optional<KernelTime> receivedAt;
+    // <-- only where the platform stamps it for us (Linux)
 };
 
 class UdpListener {
@@ -20,11 +38,18 @@ private:
     MinimalSocket::udp::Udp<false> socket;
     // <-- the "false" stands for "non-blocking"
 
-    const std::size_t maxMessageSize = 1024;
-    // <-- UDP message size as limited by WLED:
+    static constexpr std::size_t maxMessageSize = 1472;
+    // <-- UDP message size as limited by WLED (it sends at most 489 LEDs in one DNRGB packet):
     // https://kno.wled.ge/interfaces/udp-realtime/
+    std::array<char, maxMessageSize> buffer{};
+    // <-- receive into this, so that no packet needs to allocate
+#ifdef __linux__
+    alignas(cmsghdr) std::array<char, KernelTimestamp::controlSize> control{};
+#endif
 
-    size_t receivedPackages_ = 0;
+    std::atomic<size_t> receivedPackages_ = 0;
+    // <-- counted on the ingest thread, read from the render thread
+    std::atomic<size_t> truncatedPackages_ = 0;
 
 public:
     explicit UdpListener(int port)
@@ -41,6 +66,10 @@ public:
                     port
             ));
         }
+        if (!KernelTimestamp::enable(socket.accessHandler())) {
+            std::cout << "[Socket] No kernel receive timestamps on this platform, network latency is not measured."
+                      << std::endl;
+        }
 
         std::cout << "[Socket] Listening for UDP packets on port " << port << std::endl;
     }
@@ -50,34 +79,91 @@ public:
         std::cout << "[Socket] Stopped listening on port " << port << std::endl;
     }
 
+#ifdef __linux__
+    std::optional<RawMessage> listen() {
+        // recvmsg() instead of the MinimalSocket receive, as only that hands out the kernel timestamp
+        sockaddr_in sender{};
+        iovec data{.iov_base = buffer.data(), .iov_len = buffer.size()};
+        msghdr header{};
+        header.msg_name = &sender;
+        header.msg_namelen = sizeof(sender);
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control.data();
+        header.msg_controllen = control.size();
+        ssize_t received;
+        while (true) {
+            header.msg_namelen = sizeof(sender);
+            header.msg_controllen = control.size();
+            received = recvmsg(socket.accessHandler(), &header, MSG_DONTWAIT);
+            if (received < 0) {
+                return std::nullopt;
+            }
+            receivedPackages_++;
+            if (!(header.msg_flags & MSG_TRUNC)) {
+                break;
+            }
+            // larger than our buffer, i.e. cut off. That is not what the sender sent, so it is not decoded.
+            truncatedPackages_++;
+        }
+        return RawMessage{
+                .bytes = std::span<const uint8_t>(
+                        reinterpret_cast<const uint8_t*>(buffer.data()),
+                        static_cast<size_t>(received)
+                ),
+                .source = PacketSource{
+                        .ipv4 = ntohl(sender.sin_addr.s_addr),
+                        .port = ntohs(sender.sin_port),
+                },
+                .receivedAt = KernelTimestamp::from(header),
+        };
+    }
+#else
     std::optional<RawMessage> listen() {
-        auto package = socket.receive(maxMessageSize);
+        auto package = socket.receive(MinimalSocket::BufferView{buffer.data(), buffer.size()});
         if (!package.has_value()) {
             return std::nullopt;
         }
         receivedPackages_++;
+        const auto& sender = package.value().sender;
         return RawMessage{
-                .values = decodeIntegers(package.value()),
-                .source = to_string(package.value().sender)
+                .bytes = std::span<const uint8_t>(
+                        reinterpret_cast<const uint8_t*>(buffer.data()),
+                        package.value().received_bytes
+                ),
+                .source = PacketSource::from(sender.getHost(), sender.getPort())
         };
     }
+#endif
+
+    // for the ingest to wait on all sockets at once
+    [[nodiscard]]
+    auto handle() const { return socket.accessHandler(); }
 
     bool runsOn(int udpPort) {
         return port == udpPort;
     }
 
-    static std::vector<int> decodeIntegers(MinimalSocket::ReceiveStringResult message) {
-        std::vector<int> values;
-        for (char c: message.received_message) {
-            auto byteValue = static_cast<uint8_t>(c);
-            auto intValue = static_cast<int>(byteValue);
-            values.push_back(intValue);
+    // e.g. for sACN, which is usually sent to one multicast group per universe
+    bool joinMulticast(uint32_t group) {
+        ip_mreq request{};
+        request.imr_multiaddr.s_addr = htonl(group);
+        request.imr_interface.s_addr = htonl(INADDR_ANY);
+        const auto result = setsockopt(socket.accessHandler(), IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                                       reinterpret_cast<const char*>(&request), sizeof(request));
+        if (result != 0) {
+            std::cerr << "[Socket] Cannot join multicast group " << PacketSource{.ipv4 = group}.host()
+                      << " on port " << port << std::endl;
+            return false;
         }
-        return values;
+        return true;
     }
 
     [[nodiscard]]
-    size_t receivedPackages() { return receivedPackages_; }
+    size_t receivedPackages() const { return receivedPackages_.load(); }
+
+    [[nodiscard]]
+    size_t truncatedPackages() const { return truncatedPackages_.load(); }
 };
 
 #endif //DLTROPHY_SIMULATOR_UDPLISTENER_H
@@ -0,0 +1,296 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_UDPRELAY_H
+#define DLTROPHY_SIMULATOR_UDPRELAY_H
+
+#include "RelaySettings.h"
+
+#ifdef __linux__
+#define HAS_UDP_RELAY
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class UdpRelay {
+    /*
+     *  Headless mode (-R on the command line): receives the sender's stream once and sends every datagram,
+     *  as it is, to several simulators, so that one ESP32 can feed them all without more WiFi airtime.
+     *  Batched both ways, recvmmsg() takes up to batchSize datagrams and one sendmmsg() goes out
+     *  per destination with all of them, pointing right into the receive buffers.
+     *
+     *  Linux only, as recvmmsg / sendmmsg are.
+     */
+
+private:
+    static constexpr size_t batchSize = 64;
+    static constexpr size_t maxDatagramSize = 1500;
+    static constexpr auto reportInterval = std::chrono::seconds(1);
+    static constexpr int pollTimeoutMs = 200;
+
+    struct Listener {
+        int port;
+        int fd;
+    };
+
+    struct Destination {
+        std::string name;
+        std::vector<sockaddr_in> addresses;
+        // <-- one per listener
+        size_t packets = 0;
+        size_t bytes = 0;
+        size_t errors = 0;
+        // <-- datagrams the kernel did not take, e.g. because the host is unreachable
+        size_t reportedPackets = 0;
+        size_t reportedBytes = 0;
+    };
+
+    std::vector<Listener> listeners;
+    std::vector<pollfd> pollEntries;
+    int sendFd = -1;
+    std::vector<Destination> destinations;
+
+    std::vector<std::array<uint8_t, maxDatagramSize>> buffers;
+    std::array<iovec, batchSize> received{};
+    std::array<mmsghdr, batchSize> receiveHeaders{};
+    std::array<mmsghdr, batchSize> sendHeaders{};
+    std::array<iovec, batchSize> sent{};
+
+    size_t receivedPackets = 0;
+    size_t truncatedPackets = 0;
+    std::chrono::steady_clock::time_point reportedAt;
+    size_t reportedReceived = 0;
+
+    static int openSocket(int port) {
+        const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            throw std::runtime_error("[Relay] Cannot create socket");
+        }
+        if (port > 0) {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_ANY);
+            address.sin_port = htons(static_cast<uint16_t>(port));
+            if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                close(fd);
+                throw std::runtime_error(std::format(
+                    "[Relay] Socket cannot listen under port {}, is it already in use?", port
+                ));
+            }
+        }
+        return fd;
+    }
+
+    static sockaddr_in resolve(const std::string& host, int port) {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+            throw std::runtime_error(std::format("[Relay] Cannot resolve destination \"{}\"", host));
+        }
+        sockaddr_in address = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+        freeaddrinfo(result);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        return address;
+    }
+
+    void addDestination(const std::string& spec) {
+        Destination destination;
+        destination.name = spec;
+        const auto colon = spec.rfind(':');
+        if (colon != std::string::npos) {
+            if (listeners.size() > 1) {
+                // one port can not take several streams apart again
+                throw std::runtime_error(std::format(
+                    "[Relay] Destination \"{}\" gives a port, but there are {} ports to relay (DDP is on?)",
+                    spec, listeners.size()
+                ));
+            }
+            const auto port = std::stoi(spec.substr(colon + 1));
+            destination.addresses.push_back(resolve(spec.substr(0, colon), port));
+        } else {
+            for (const auto& listener : listeners) {
+                destination.addresses.push_back(resolve(spec, listener.port));
+            }
+        }
+        destinations.push_back(std::move(destination));
+    }
+
+    void relay(size_t listenerIndex, size_t nReceived) {
+        // a truncated datagram is not what the sender sent, it is not passed on
+        size_t count = 0;
+        for (size_t i = 0; i < nReceived; i++) {
+            if (receiveHeaders[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                continue;
+            }
+            sent[count++] = {
+                .iov_base = received[i].iov_base,
+                .iov_len = receiveHeaders[i].msg_len,
+            };
+        }
+        if (count == 0) {
+            return;
+        }
+        for (auto& destination : destinations) {
+            auto& address = destination.addresses[listenerIndex];
+            for (size_t i = 0; i < count; i++) {
+                sendHeaders[i].msg_hdr = msghdr{};
+                sendHeaders[i].msg_hdr.msg_name = &address;
+                sendHeaders[i].msg_hdr.msg_namelen = sizeof(address);
+                sendHeaders[i].msg_hdr.msg_iov = &sent[i];
+                sendHeaders[i].msg_hdr.msg_iovlen = 1;
+            }
+            size_t done = 0;
+            while (done < count) {
+                const int n = sendmmsg(sendFd, sendHeaders.data() + done, count - done, 0);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // this one did not go out, try the rest anyway
+                    destination.errors++;
+                    done++;
+                    continue;
+                }
+                for (int i = 0; i < n; i++) {
+                    destination.bytes += sendHeaders[done + i].msg_len;
+                }
+                destination.packets += n;
+                done += n;
+            }
+        }
+    }
+
+    void receive(size_t listenerIndex) {
+        // drain what is there, a batch at a time
+        while (true) {
+            for (size_t i = 0; i < batchSize; i++) {
+                received[i] = {.iov_base = buffers[i].data(), .iov_len = buffers[i].size()};
+                receiveHeaders[i].msg_hdr = msghdr{};
+                receiveHeaders[i].msg_hdr.msg_iov = &received[i];
+                receiveHeaders[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int n = recvmmsg(listeners[listenerIndex].fd, receiveHeaders.data(), batchSize,
+                                   MSG_DONTWAIT, nullptr);
+            if (n <= 0) {
+                return;
+            }
+            for (int i = 0; i < n; i++) {
+                if (receiveHeaders[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    truncatedPackets++;
+                }
+            }
+            receivedPackets += n;
+            relay(listenerIndex, n);
+            if (static_cast<size_t>(n) < batchSize) {
+                return;
+            }
+        }
+    }
+
+    void report() {
+        const auto now = std::chrono::steady_clock::now();
+        const auto seconds = std::chrono::duration<double>(now - reportedAt).count();
+        if (now - reportedAt < reportInterval) {
+            return;
+        }
+        std::cout << std::fixed << std::setprecision(0)
+                  << "[Relay] in: " << static_cast<double>(receivedPackets - reportedReceived) / seconds
+                  << " packets/s (" << receivedPackets << " total, " << truncatedPackets << " truncated)"
+                  << std::endl;
+        for (auto& destination : destinations) {
+            std::cout << "[Relay]   -> " << std::left << std::setw(24) << destination.name << std::right
+                      << std::setw(8) << static_cast<double>(destination.packets - destination.reportedPackets) / seconds
+                      << " packets/s" << std::setw(8)
+                      << static_cast<double>(destination.bytes - destination.reportedBytes) / seconds / 1024.
+                      << " kB/s, " << destination.errors << " errors" << std::endl;
+            destination.reportedPackets = destination.packets;
+            destination.reportedBytes = destination.bytes;
+        }
+        reportedAt = now;
+        reportedReceived = receivedPackets;
+    }
+
+    void teardown() {
+        for (const auto& listener : listeners) {
+            close(listener.fd);
+        }
+        if (sendFd >= 0) {
+            close(sendFd);
+        }
+    }
+
+public:
+    explicit UdpRelay(const RelaySettings& settings)
+    : buffers(batchSize)
+    {
+        try {
+            for (auto port : settings.ports) {
+                if (port <= 0) {
+                    continue;
+                }
+                listeners.push_back({.port = port, .fd = openSocket(port)});
+                pollEntries.push_back({.fd = listeners.back().fd, .events = POLLIN, .revents = 0});
+            }
+            sendFd = openSocket(0);
+            for (const auto& spec : settings.destinations) {
+                addDestination(spec);
+            }
+        } catch (...) {
+            teardown();
+            throw;
+        }
+        if (listeners.empty() || destinations.empty()) {
+            teardown();
+            throw std::runtime_error("[Relay] Needs at least one port to listen on and one destination");
+        }
+        for (const auto& listener : listeners) {
+            std::cout << "[Relay] Listening on port " << listener.port << std::endl;
+        }
+        for (const auto& destination : destinations) {
+            std::cout << "[Relay] Sending on to " << destination.name << std::endl;
+        }
+    }
+
+    ~UdpRelay() {
+        teardown();
+    }
+
+    UdpRelay(const UdpRelay&) = delete;
+    UdpRelay& operator=(const UdpRelay&) = delete;
+
+    void run(const std::atomic<bool>& alive) {
+        reportedAt = std::chrono::steady_clock::now();
+        while (alive) {
+            if (poll(pollEntries.data(), pollEntries.size(), pollTimeoutMs) > 0) {
+                for (size_t l = 0; l < listeners.size(); l++) {
+                    if (pollEntries[l].revents & POLLIN) {
+                        receive(l);
+                    }
+                }
+            }
+            report();
+        }
+    }
+};
+
+#endif
+#endif //DLTROPHY_SIMULATOR_UDPRELAY_H
@@ -0,0 +1,370 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_URINGRECEIVER_H
+#define DLTROPHY_SIMULATOR_URINGRECEIVER_H
+
+#ifdef __linux__
+#define HAS_URING_RECEIVER
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "PacketSource.h"
+#include "KernelTimestamp.h"
+
+class UringReceiver {
+    /*
+     *  Linux-only UDP receive path, selected via "udpBackend": "io_uring" in the config.
+     *
+     *  One multishot RECVMSG stays armed on the socket and the kernel picks a slab from a
+     *  registered provided-buffer ring for each datagram, so there is no syscall per packet
+     *  and no allocation -- the payload is handed out as a span into the slab, which is given
+     *  back to the kernel right after the callback returned.
+     *
+     *  Talks to the kernel via raw syscalls, because liburing is not worth the dependency here.
+     *  Needs Linux >= 6.0 (multishot recvmsg), throws if anything is not supported.
+     */
+
+private:
+    static constexpr unsigned queueDepth = 8;
+    static constexpr unsigned nBuffers = 256;
+    // <-- must be a power of two
+    static constexpr size_t slabSize = 2048;
+    // <-- needs to fit io_uring_recvmsg_out + sockaddr_in + the timestamp + the largest datagram we care about
+    static constexpr uint16_t bufferGroup = 0;
+    static constexpr uint64_t recvTag = 1;
+
+    int port;
+    int socketFd = -1;
+    int ringFd = -1;
+
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    io_uring_buf_ring* bufferRing = static_cast<io_uring_buf_ring*>(MAP_FAILED);
+    size_t bufferRingSize = 0;
+    uint16_t bufferTail = 0;
+    std::vector<uint8_t> slabs;
+
+    msghdr receiveHeader{};
+
+    std::atomic<size_t> truncatedPackages_{0};
+    // <-- counted on the ingest thread, read from the render thread
+    static int setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+                     const void* arg, size_t argSize) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+    }
+
+    static int registerRing(int fd, unsigned opcode, void* arg, unsigned nArgs) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nArgs));
+    }
+
+    [[noreturn]]
+    static void fail(const std::string& what) {
+        throw std::runtime_error(std::format("[io_uring] {} ({})", what, std::strerror(errno)));
+    }
+
+    void openSocket() {
+        socketFd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (socketFd < 0) {
+            fail("Cannot create socket");
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            fail(std::format("Socket cannot listen under port {0}, is it already in use?", port));
+        }
+        if (!KernelTimestamp::enable(socketFd)) {
+            std::cerr << "[io_uring] No kernel receive timestamps, network latency is not measured." << std::endl;
+        }
+    }
+
+    void mapRings() {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = nBuffers;
+        // <-- a full completion queue ends the multishot receive, so give it room for a burst
+        ringFd = setup(queueDepth, &params);
+        if (ringFd < 0) {
+            fail("io_uring_setup failed");
+        }
+        if (!(params.features & IORING_FEAT_EXT_ARG)) {
+            errno = ENOTSUP;
+            fail("Kernel has no IORING_FEAT_EXT_ARG");
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            fail("Cannot map submission ring");
+        }
+        if (singleMap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                fail("Cannot map completion ring");
+            }
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            fail("Cannot map submission entries");
+        }
+
+        auto sq = static_cast<uint8_t*>(sqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto cq = static_cast<uint8_t*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void registerBuffers() {
+        bufferRingSize = nBuffers * sizeof(io_uring_buf);
+        bufferRing = static_cast<io_uring_buf_ring*>(mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE,
+                                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (bufferRing == MAP_FAILED) {
+            fail("Cannot allocate provided buffer ring");
+        }
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+        reg.ring_entries = nBuffers;
+        reg.bgid = bufferGroup;
+        if (registerRing(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            fail("Cannot register provided buffer ring");
+        }
+
+        slabs.resize(nBuffers * slabSize);
+        for (uint16_t bid = 0; bid < nBuffers; bid++) {
+            provide(bid);
+        }
+        publishBuffers();
+    }
+
+    void provide(uint16_t bid) {
+        // not via bufferRing->bufs, __DECLARE_FLEX_ARRAY has an empty struct in front, which is not empty in C++
+        auto& buffer = reinterpret_cast<io_uring_buf*>(bufferRing)[bufferTail & (nBuffers - 1)];
+        buffer.addr = reinterpret_cast<uint64_t>(slabs.data() + bid * slabSize);
+        buffer.len = slabSize;
+        buffer.bid = bid;
+        bufferTail++;
+    }
+
+    void publishBuffers() {
+        std::atomic_ref<uint16_t>(bufferRing->tail)
+            .store(bufferTail, std::memory_order_release);
+    }
+
+    void armReceive() {
+        receiveHeader = msghdr{};
+        receiveHeader.msg_namelen = sizeof(sockaddr_in);
+        receiveHeader.msg_controllen = KernelTimestamp::controlSize;
+        // <-- multishot only looks at the lengths, the kernel puts name and control into the slab
+
+        const unsigned tail = *sqTail;
+        const unsigned index = tail & sqMask;
+        auto& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_RECVMSG;
+        sqe.fd = socketFd;
+        sqe.addr = reinterpret_cast<uint64_t>(&receiveHeader);
+        sqe.len = 1;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = bufferGroup;
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.user_data = recvTag;
+        sqArray[index] = index;
+        std::atomic_ref<unsigned>(*sqTail).store(tail + 1, std::memory_order_release);
+
+        if (enter(ringFd, 1, 0, 0, nullptr, 0) < 0) {
+            fail("Cannot submit multishot receive");
+        }
+    }
+
+    void teardown() {
+        if (bufferRing != MAP_FAILED) {
+            munmap(bufferRing, bufferRingSize);
+        }
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (ringFd >= 0) {
+            close(ringFd);
+        }
+        if (socketFd >= 0) {
+            close(socketFd);
+        }
+    }
+
+    std::optional<KernelTime> receivedAt(const uint8_t* slab, const io_uring_recvmsg_out& out) const {
+        // the control messages follow the (full size of the) name, parse them as recvmsg() would have
+        msghdr header{};
+        header.msg_control = const_cast<uint8_t*>(slab + sizeof(io_uring_recvmsg_out) + receiveHeader.msg_namelen);
+        header.msg_controllen = out.controllen;
+        header.msg_flags = static_cast<int>(out.flags);
+        return KernelTimestamp::from(header);
+    }
+
+public:
+    explicit UringReceiver(int port)
+    : port(port) {
+        try {
+            openSocket();
+            mapRings();
+            registerBuffers();
+            armReceive();
+        } catch (...) {
+            teardown();
+            throw;
+        }
+        std::cout << "[Socket] Listening for UDP packets on port " << port << " (io_uring)" << std::endl;
+    }
+
+    ~UringReceiver() {
+        teardown();
+        std::cout << "[Socket] Stopped listening on port " << port << std::endl;
+    }
+
+    // becomes readable when completions are there, so the ring can be waited on together with other sockets
+    [[nodiscard]]
+    int pollHandle() const { return ringFd; }
+
+    [[nodiscard]]
+    size_t truncatedPackages() const { return truncatedPackages_.load(); }
+
+    UringReceiver(const UringReceiver&) = delete;
+    UringReceiver& operator=(const UringReceiver&) = delete;
+
+    /**
+     *  Blocks until at least one datagram arrived or the timeout passed,
+     *  then calls onPacket(std::span<const uint8_t> payload, const sockaddr_in& sender,
+     *                     std::optional<KernelTime> receivedAt)
+     *  for everything that is completed. Returns the number of datagrams.
+     */
+    template <typename OnPacket>
+    size_t receive(OnPacket&& onPacket, std::chrono::milliseconds timeout) {
+        __kernel_timespec ts{
+            .tv_sec = timeout.count() / 1000,
+            .tv_nsec = (timeout.count() % 1000) * 1000000,
+        };
+        io_uring_getevents_arg arg{};
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        // <-- ETIME / EINTR are fine, we just look at what is there.
+
+        const size_t headerSize = sizeof(io_uring_recvmsg_out)
+                                  + receiveHeader.msg_namelen
+                                  + receiveHeader.msg_controllen;
+        size_t received = 0;
+        bool needsRearm = false;
+
+        unsigned head = *cqHead;
+        const unsigned tail = std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            const auto& cqe = cqes[head & cqMask];
+            if (cqe.user_data != recvTag) {
+                continue;
+            }
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                // e.g. -ENOBUFS when we did not hand back the slabs fast enough
+                needsRearm = true;
+            }
+            if (cqe.res < 0 || !(cqe.flags & IORING_CQE_F_BUFFER)) {
+                continue;
+            }
+            const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res >= static_cast<int>(headerSize)) {
+                const uint8_t* slab = slabs.data() + bid * slabSize;
+                const auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(slab);
+                const auto* sender = reinterpret_cast<const sockaddr_in*>(slab + sizeof(io_uring_recvmsg_out));
+                if (out->flags & MSG_TRUNC) {
+                    // did not fit into the slab, i.e. is not what the sender sent
+                    truncatedPackages_++;
+                } else if (out->namelen >= sizeof(sockaddr_in)) {
+                    onPacket(
+                        std::span<const uint8_t>(slab + headerSize, cqe.res - headerSize),
+                        *sender,
+                        receivedAt(slab, *out)
+                    );
+                    received++;
+                }
+            }
+            provide(bid);
+        }
+        std::atomic_ref<unsigned>(*cqHead).store(head, std::memory_order_release);
+        publishBuffers();
+
+        if (needsRearm) {
+            armReceive();
+        }
+        return received;
+    }
+
+    static PacketSource toSource(const sockaddr_in& sender) {
+        return PacketSource{
+            .ipv4 = ntohl(sender.sin_addr.s_addr),
+            .port = ntohs(sender.sin_port),
+        };
+    }
+};
+
+#endif // __linux__
+
+#endif //DLTROPHY_SIMULATOR_URINGRECEIVER_H
@@ -5,31 +5,35 @@
 #ifndef DLTROPHY_SIMULATOR_SOCKETSERVICE_H
 #define DLTROPHY_SIMULATOR_SOCKETSERVICE_H
 
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <iostream>
 #include <mutex>
-#include <queue>
+#include <span>
 #include <string>
-#include <iostream>
-#include <thread>
-#include <ctime>
 #include "ixwebsocket/IXWebSocket.h"
+#include "LedFrame.h"
+#include "RgbKernel.h"
 #include "timeFormat.h"
 
-struct LiveviewMessage {
-    char header; // required to be L
-    int version; // required to be 2 (for 2D)
-    Size size{};
-    std::vector<LED> colors{};
-    std::string error;
-    std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
-
-    [[nodiscard]]
-    std::string formattedTime() const {
-        return formatTime(timestamp);
-    }
+struct LiveviewStats {
+    size_t frames = 0;
+    size_t overwritten = 0;
+    // <-- arrived while the previous one was not taken yet, latest wins
+    size_t unreadable = 0;
+    int width = 0;
+    int height = 0;
+    // <-- as the device says, 1 for the non-2D (version 1) frames
 };
 
 class WebSocketListener {
-    // unused since the UdpListener now works
+    /*
+     *  WLED's liveview over its websocket (ws://<host>/ws), for stock devices that can not run our UDP usermod.
+     *  Everything happens in the callbacks of the IXWebSocket thread, which also reconnects by itself:
+     *  every "L" frame is decoded into a back buffer and swapped into a mailbox of one frame,
+     *  from where the render loop takes it -- a frame that was not taken in time is just replaced.
+     */
 
 public:
     enum class State {
@@ -40,13 +44,21 @@ public:
 
 private:
     std::string endpoint_;
+    const size_t nLeds_;
     ix::WebSocket socket;
+    std::atomic<State> state{State::Connecting};
 
-    std::thread thread;
-    std::queue<LiveviewMessage> queue;
-    std::mutex queueMutex;
-    std::atomic<State> state{State::Disconnected};
-    std::atomic<bool> hasError{false};
+    LedFrame incoming;
+    // <-- only on the IXWebSocket thread
+    LedFrame mailbox;
+    bool fresh = false;
+    std::mutex mailboxMutex;
+
+    std::atomic<size_t> frames_{0};
+    std::atomic<size_t> overwritten_{0};
+    std::atomic<size_t> unreadable_{0};
+    std::atomic<int> width_{0};
+    std::atomic<int> height_{0};
 
     template<typename... Args>
     static void log(std::format_string<Args...> fmt, Args&&... args) {
@@ -56,158 +68,161 @@ private:
                   << message << std::endl;
     }
 
-    static LiveviewMessage interpret(const std::string& message) {
-        LiveviewMessage result{
-            .header = message[0],
-            .version = message[1],
-        };
-        if (result.header != 'L') {
-            result.error = "First Byte has to be \"L\" (76)";
-            return result;
+    // "L" <version> [<width> <height> for version 2] R G B R G B ..., straight into the back buffer.
+    bool interpret(std::span<const uint8_t> bytes) {
+        if (bytes.size() < 2 || bytes[0] != 'L') {
+            return false;
         }
-        auto length = static_cast<int>(message.size());
-        int startIndex;
-        switch (result.version) {
+        size_t start;
+        switch (bytes[1]) {
             case 1:
-                result.size = {static_cast<int>(message.size()) - 2, 1};
-                startIndex = 2;
+                start = 2;
+                width_ = static_cast<int>((bytes.size() - start) / 3);
+                height_ = 1;
                 break;
             case 2:
-                result.size = {message[2], message[3]};
-                startIndex = 4;
+                if (bytes.size() < 4) {
+                    return false;
+                }
+                start = 4;
+                width_ = bytes[2];
+                height_ = bytes[3];
                 break;
             default:
-                result.error = "Version Byte is not known";
-                return result;
-        }
-
-        try {
-            for (size_t i = startIndex; i < length; i += 3) {
-                result.colors.push_back(
-                        LED(message[i], message[i + 1], message[i + 2])
-                );
-            }
-        } catch (const std::exception& e) {
-            result.error = e.what();
+                return false;
         }
-        return result;
+        const auto given = std::min((bytes.size() - start) / 3, incoming.leds.size());
+        RgbKernel::unpack(bytes.data() + start, incoming.leds.data(), given);
+        // <-- the buffer has been through other frames, what this one does not reach is dark
+        std::fill(incoming.leds.begin() + static_cast<std::ptrdiff_t>(given), incoming.leds.end(), LED());
+        incoming.decodedAt = std::chrono::steady_clock::now();
+        incoming.receivedAt = incoming.decodedAt;
+        incoming.packets = 1;
+        return true;
     }
 
     void onMessage(const ix::WebSocketMessagePtr &msg) {
         switch (msg->type) {
             case ix::WebSocketMessageType::Message: {
-                    std::lock_guard<std::mutex> lock(queueMutex);
-                    auto message = interpret(msg->str);
-                    queue.push(message);
+                const auto bytes = std::span<const uint8_t>(
+                    reinterpret_cast<const uint8_t*>(msg->str.data()),
+                    msg->str.size()
+                );
+                if (!msg->binary) {
+                    // the state JSON that WLED sends along, not what we are here for
+                    break;
+                }
+                if (!interpret(bytes)) {
+                    unreadable_++;
+                    break;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mailboxMutex);
+                    if (fresh) {
+                        overwritten_++;
+                    }
+                    std::swap(mailbox, incoming);
+                    fresh = true;
                 }
+                frames_++;
                 break;
+            }
             case ix::WebSocketMessageType::Open:
-                log("Open");
+                state = State::Connected;
+                socket.send("{\"lv\": true}");
+                log("Listening to the liveview of {}", endpoint_);
                 break;
             case ix::WebSocketMessageType::Close:
-                log("Close");
+                state = State::Connecting;
+                // <-- IXWebSocket tries again by itself
+                log("Closed");
                 break;
             case ix::WebSocketMessageType::Error: {
                 auto err = msg->errorInfo;
-                log("Error {}: {} ({} {}{})",
+                state = State::Connecting;
+                log("Error {}: {} ({} retries, next in {} ms)",
                     err.http_status,
                     err.reason,
                     err.retries,
-                    err.wait_time,err.decompressionError ? " decompr" : "");
+                    err.wait_time);
                 }
-                hasError = true;
-                break;
-            case ix::WebSocketMessageType::Ping:
-                log("Ping");
-                break;
-            case ix::WebSocketMessageType::Pong:
-                log("Pong");
                 break;
-            case ix::WebSocketMessageType::Fragment:
-                log("Fragment");
+            default:
                 break;
         }
     }
 
-    void run() {
-        state = State::Connecting;
-        auto url = std::format("ws://{}", endpoint_);
+public:
+    WebSocketListener(const std::string& endpoint, size_t nLeds)
+    : endpoint_(endpoint),
+      nLeds_(nLeds),
+      incoming{.leds = std::vector<LED>(nLeds)},
+      mailbox{.leds = std::vector<LED>(nLeds)}
+    {
+        // the host alone is enough, that is where WLED has it
+        auto url = endpoint.find('/') == std::string::npos
+            ? std::format("ws://{}/ws", endpoint)
+            : std::format("ws://{}", endpoint);
         socket.setUrl(url);
         socket.setOnMessageCallback(
                 [this](const auto& msg) {
                     this->onMessage(msg);
                 });
         socket.start();
-
-        log("Initiating Websocket under {}", url);
-        while (socket.getReadyState() != ix::ReadyState::Open) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            if (hasError.load()) {
-                socket.stop();
-                state = State::Disconnected;
-                return;
-            }
-        }
-        state = State::Connected;
-        std::string startMessage = "{\"lv\": true}";
-        socket.send(startMessage);
-
-        log("Listening.");
-        while (socket.getReadyState() != ix::ReadyState::Closed) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        state = State::Disconnected;
-        log("Stopped listening.");
-    }
-
-public:
-    explicit WebSocketListener(const std::string& endpoint) {
-        connect(endpoint);
+        log("Connecting to {}", url);
     }
 
     ~WebSocketListener() {
-        disconnect();
+        socket.stop();
     }
 
+    WebSocketListener(const WebSocketListener&) = delete;
+    WebSocketListener& operator=(const WebSocketListener&) = delete;
+
     [[nodiscard]]
     State connectionState() const { return state.load(); }
 
-    void disconnect() {
-        socket.stop();
-        if (thread.joinable()) {
-            thread.join();
+    [[nodiscard]]
+    const char* stateName() const {
+        switch (connectionState()) {
+            case State::Connected:
+                return "connected";
+            case State::Connecting:
+                return "connecting";
+            default:
+                return "disconnected";
         }
-        state = State::Disconnected;
-        hasError = false;
     }
 
-    void connect(const std::string& endpoint) {
-        if (connectionState() != State::Disconnected) {
-            disconnect();
+    // from the render thread, swaps its own buffer in. false if nothing new came.
+    bool takeLatest(LedFrame& frame) {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        if (!fresh) {
+            return false;
         }
-        endpoint_ = endpoint;
-        thread = std::thread([this] { this->run(); });
+        std::swap(frame, mailbox);
+        fresh = false;
+        return true;
     }
 
-    std::optional<LiveviewMessage> listen() {
-        if (connectionState() != State::Connected) {
-            return std::nullopt;
-        }
-
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (queue.empty()) {
-            return std::nullopt;
-        }
-        auto message = std::move(queue.front());
-        queue.pop();
-        return message;
+    [[nodiscard]]
+    LiveviewStats stats() const {
+        return {
+            .frames = frames_.load(),
+            .overwritten = overwritten_.load(),
+            .unreadable = unreadable_.load(),
+            .width = width_.load(),
+            .height = height_.load(),
+        };
     }
 
     [[nodiscard]]
-    bool isRunningUnder(const std::string& endpoint) const {
-        return connectionState() == State::Connected
-               && endpoint == endpoint_;
+    bool isRunningUnder(const std::string& endpoint, size_t nLeds) const {
+        return endpoint == endpoint_ && nLeds == nLeds_;
     }
+
+    [[nodiscard]]
+    const std::string& endpoint() const { return endpoint_; }
 };
 
 #endif //DLTROPHY_SIMULATOR_SOCKETSERVICE_H
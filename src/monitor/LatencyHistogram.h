@@ -0,0 +1,121 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+#ifndef DLTROPHY_SIMULATOR_LATENCYHISTOGRAM_H
+#define DLTROPHY_SIMULATOR_LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+struct LatencySummary {
+    size_t count = 0;
+    double p50Millis = 0;
+    double p99Millis = 0;
+    double maxMillis = 0;
+};
+
+class LatencyHistogram {
+    /*
+     *  HDR-style: every power of two is split into 16 linear buckets, so any value is kept within ~6%,
+     *  from single nanoseconds to about 18 minutes, in a fixed array -- recording never allocates.
+     *
+     *  Only one thread may record() and reset(), any thread may read.
+     */
+
+private:
+    static constexpr int subBucketBits = 4;
+    static constexpr uint64_t subBuckets = 1 << subBucketBits;
+    static constexpr int maxExponent = 39;
+    // <-- 2^40 ns, everything above lands in the last bucket (max() is still exact)
+    static constexpr size_t nBuckets = (maxExponent - subBucketBits) * subBuckets + 2 * subBuckets;
+
+    std::array<std::atomic<uint64_t>, nBuckets> counts{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> maxNanos{0};
+
+    static size_t bucketOf(uint64_t nanos) {
+        if (nanos < subBuckets) {
+            return nanos;
+        }
+        const int exponent = std::min(static_cast<int>(std::bit_width(nanos)) - 1, maxExponent);
+        const int shift = exponent - subBucketBits;
+        const auto mantissa = std::min(nanos >> shift, 2 * subBuckets - 1);
+        return shift * subBuckets + mantissa;
+    }
+
+    static uint64_t valueOf(size_t bucket) {
+        // the middle of the bucket, as good a guess as any
+        if (bucket < 2 * subBuckets) {
+            return bucket;
+        }
+        const auto shift = bucket / subBuckets - 1;
+        const auto mantissa = bucket % subBuckets + subBuckets;
+        return (mantissa << shift) + (1ull << shift) / 2;
+    }
+
+    static double toMillis(uint64_t nanos) {
+        return static_cast<double>(nanos) * 1e-6;
+    }
+
+public:
+    void record(std::chrono::nanoseconds duration) {
+        // a negative one can happen when the wall clock was set in between, count it as zero
+        const auto nanos = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+        counts[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        if (nanos > maxNanos.load(std::memory_order_relaxed)) {
+            maxNanos.store(nanos, std::memory_order_relaxed);
+        }
+    }
+
+    void reset() {
+        for (auto& count : counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        maxNanos.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+
+    [[nodiscard]]
+    std::chrono::nanoseconds max() const {
+        return std::chrono::nanoseconds(maxNanos.load(std::memory_order_relaxed));
+    }
+
+    [[nodiscard]]
+    std::chrono::nanoseconds percentile(double fraction) const {
+        const auto n = count();
+        if (n == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(n))));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < nBuckets; bucket++) {
+            seen += counts[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(std::min(valueOf(bucket), maxNanos.load(std::memory_order_relaxed)));
+            }
+        }
+        return max();
+    }
+
+    [[nodiscard]]
+    LatencySummary summary() const {
+        return {
+            .count = count(),
+            .p50Millis = toMillis(percentile(0.5).count()),
+            .p99Millis = toMillis(percentile(0.99).count()),
+            .maxMillis = toMillis(max().count()),
+        };
+    }
+};
+
+#endif //DLTROPHY_SIMULATOR_LATENCYHISTOGRAM_H
@@ -0,0 +1,89 @@
+// what fragment.glsl and post.glsl both need, i.e. the parameters, the border frame and the post processing.
+// GLSL has no #include of its own, the TrophyShader puts this file in place of the `#include "common.glsl"` line.
+
+uniform vec4 iRect;
+uniform sampler2D iBloomImage;
+
+layout(std140) uniform StateBuffer {
+    float ledSize, ledGlow;
+    float camX, camY, camZ, camFov, camTilt;
+    float fogScaling, fogGrading, backgroundSpin;
+    float floorLevel, floorGraytone, floorLineBrightness,
+          floorSpacingX, floorSpacingZ,
+          floorLineWidth, floorExponent, floorGrading;
+    float pyramidX, pyramidY, pyramidZ,
+          pyramidScale, pyramidHeight,
+          pyramidAngle, pyramidAngularVelocity;
+    float epoxyPermittivity;
+    float blendPreviousMixing;
+    float traceMinDistance, traceMaxDistance, traceFixedStep;
+    int traceMaxSteps, traceMaxRecursions;
+    float ledBlurSamples, ledBlurRadius, ledBlurPrecision,
+          ledBlurMixing;
+};
+
+const vec4 c = vec4(1., 0., -1., .5);
+
+const vec3 borderDark = vec3(0.4);
+const vec3 borderLight = vec3(0.6);
+
+vec2 iResolution = iRect.zw;
+float aspectRatio = iResolution.x / iResolution.y;
+
+bool inBorderFrame(in vec2 uv, out vec3 col) {
+    float uvX = uv.x / aspectRatio;
+    if (max(abs(uvX), abs(uv.y)) <= 0.993) {
+        return false;
+    }
+    if (abs(uvX) >= abs(uv.y)) { // vertical frame?
+        col = uvX < 0 ? borderDark : borderLight;
+    } else {
+        col = uv.y > 0 ? borderDark : borderLight;
+    }
+    return true;
+}
+
+const float goldenPhi = 2.39996323;
+
+vec3 blurredBloomImage(in vec2 st) {
+    vec4 result = c.yyyy;
+    for (float s = 0.; s < ledBlurSamples; s+= 1.) {
+        float r = ledBlurRadius * sqrt((s + 0.5) / ledBlurSamples) * 1./iResolution.y;
+        float theta = s * goldenPhi;
+        // theta += 0.05 * hash1(globalSeed);
+        vec2 offset = r * vec2(cos(theta), sin(theta));
+        r *= ledBlurPrecision * 0.01/ledSize;
+        float weight = exp(-r * r);
+        result.rgb += weight * texture(iBloomImage, st + offset).rgb;
+        result.a += weight;
+    }
+    return mix(
+        texture(iBloomImage, st).rgb,
+        result.rgb / result.a,
+        ledBlurMixing
+    );
+}
+
+const float postExposure = 1.2;
+const vec3 postGamma = vec3(0.8);
+
+void postProcess(inout vec3 col, in vec2 uv, in vec2 st) {
+    vec3 bloomImage = blurredBloomImage(st);
+    float brightness = 1.5 * dot(bloomImage, vec3(0.2126, 0.7152, 0.0722));
+//    brightness = pow(brightness, 0.5);
+//    col = mix(col + 0.1 * bloomImage, bloomImage, brightness);
+    col = mix(col, bloomImage, brightness);
+//    col = 1. - exp(-col * (postExposure + brightness));
+//    col = pow(col, postGamma);
+
+    // simple vignette for now.
+    float rf = length(uv) * 0.9;
+    rf = pow(rf, 4.2) + 1.;
+    rf = pow(rf, -1.6);
+    col *= clamp(rf, 0., 1.);
+
+    // gamma grading
+    // col = pow(col, vec3(1.4));
+    // gain
+    // col = col * 4.0/(2.5 + col);
+}
@@ -17,7 +17,7 @@ void main() {
 }
 )";
 
-// version from 2025/09/12
+// version from 2026/10/16
 extern const char embedded_fragment_shader[] = R"(
 #version 330 core
 
@@ -27,65 +27,64 @@ layout (location = 0) out vec4 fragColor;
 layout (location = 1) out vec4 extraOutput;
 
 uniform float iTime;
-uniform vec4 iRect;
 uniform float iFPS;
 uniform vec4 iMouse;
 uniform int iFrame;
 uniform int iPass;
 uniform sampler2D iPreviousImage;
-uniform sampler2D iBloomImage;
 
 const int ONLY_LEDS_PASS = 0;
 const int SCENE_PASS = 1;
 const int POST_PASS = 2;
 bool onlyLeds = iPass == ONLY_LEDS_PASS;
 
-const int nLeds = 172; // needed hardcode to be used in the uniform layout below
-
-layout(std140) uniform TrophyDefinition {
-    int _nLedsWouldNotWorkThatWay;
-    vec4 ledPosition[nLeds];
-};
-
-struct RGB { // last value is only for alignment, never used.
-    uint r, g, b, _;
-};
-
-layout(std140) uniform StateBuffer {
-    RGB ledColor[nLeds];
-    float ledSize, ledGlow;
-    float camX, camY, camZ, camFov, camTilt;
-    float fogScaling, fogGrading, backgroundSpin;
-    float floorLevel, floorGraytone, floorLineBrightness,
-          floorSpacingX, floorSpacingZ,
-          floorLineWidth, floorExponent, floorGrading;
-    float pyramidX, pyramidY, pyramidZ,
-          pyramidScale, pyramidHeight,
-          pyramidAngle, pyramidAngularVelocity;
-    float epoxyPermittivity;
-    float blendPreviousMixing;
-    float traceMinDistance, traceMaxDistance, traceFixedStep;
-    int traceMaxSteps, traceMaxRecursions;
-    float ledBlurSamples, ledBlurRadius, ledBlurPrecision,
-          ledBlurMixing;
-    int options;
-};
-
-#define hasOption(index) (options & (1 << (8 * index))) != 0
-
-bool showGrid = hasOption(0);
-bool accumulateForever = hasOption(1);
-bool noStochasticVariation = hasOption(2);
-bool onlyPyramidFrame = hasOption(3);
-
-vec3 to_vec(RGB rgb) {
-    return vec3(rgb.r, rgb.g, rgb.b) / 255.;
-}
+// the same for every pixel of a frame, so computed once on the CPU (cf. TrophyShader::setFrameConstants())
+uniform mat3 pyramidRotation;
+uniform mat3 camRotation;
+uniform vec3 lightDir;
+uniform vec3 floorColor;
+
+uniform int nLeds;
+// texture buffers, so neither their size is fixed here nor are they padded to vec4 each
+uniform samplerBuffer ledPositions; // RGBA32F, xyz
+uniform samplerBuffer ledColors; // RGBA8, i.e. already normalized
+
+vec3 ledPosition(int index) {
+    return texelFetch(ledPositions, index).xyz;
+}
+
+vec3 ledColor(int index) {
+    return texelFetch(ledColors, index).rgb;
+}
+
+#include "common.glsl"
+
+// the options come as #defines, i.e. every combination is its own program (cf. TrophyShader::fragmentVariant()),
+// so the compiler drops whatever is switched off. Without any, this file is the variant with all of them off.
+#ifdef SHOW_GRID
+const bool showGrid = true;
+#else
+const bool showGrid = false;
+#endif
+#ifdef ACCUMULATE_FOREVER
+const bool accumulateForever = true;
+#else
+const bool accumulateForever = false;
+#endif
+#ifdef NO_STOCHASTIC_VARIATION
+const bool noStochasticVariation = true;
+#else
+const bool noStochasticVariation = false;
+#endif
+#ifdef ONLY_PYRAMID_FRAME
+const bool onlyPyramidFrame = true;
+#else
+const bool onlyPyramidFrame = false;
+#endif
 
 const float pi = 3.14159265;
 const float rad = pi / 180.;
 const float tau = 2. * pi;
-const vec4 c = vec4(1., 0., -1., .5);
 
 const int MISS = -1;
 const int LED_MATERIAL = 0;
@@ -95,12 +94,6 @@ const int PYRAMID_FRAME_MATERIAL = 3;
 const int LED_FRAME_MATERIAL = 4;
 const int DEBUG_MATERIAL = 99;
 
-const vec3 borderDark = vec3(0.4);
-const vec3 borderLight = vec3(0.6);
-
-vec2 iResolution = iRect.zw;
-float aspectRatio = iResolution.x / iResolution.y;
-
 vec3 draw_grid(in vec2 uv) {
     vec3 col = c.yyy;
     float thickness = 3.e-3;
@@ -237,7 +230,6 @@ vec3 background(vec3 rd, vec3 ld) {
 
 ////
 
-vec3 floorColor = vec3(0., 0.73 - 0.2 * cos(iTime), 0.94 - 0.05 * sin(0.4 * iTime));
 const vec3 floorNormal = c.yxy;
 
 Marched sdFloor(vec3 p) {
@@ -287,9 +279,6 @@ float sdPyramidFrame(vec3 p) {
     return frameDist - 0.0025; // <-- frame thickness
 }
 
-mat3 pyramidRotation = rotateY(pyramidAngle + pyramidAngularVelocity * iTime);
-mat3 pyramidCounterRotation = rotateY(-pyramidAngle - pyramidAngularVelocity * iTime);
-
 // thanks iq https://iquilezles.org/articles/distfunctions/
 float sdPyramid( vec3 p )
 {
@@ -329,13 +318,13 @@ Marched sdScene(vec3 p) {
     p *= pyramidRotation;
     for (int i = 0; i < nLeds; i++) {
         if (i >= 64 && i < 64 + 106) {
-            sd = sdZCylinder(p - ledPosition[i].xyz, ledSize * 0.7, ledSize * 0.3);
+            sd = sdZCylinder(p - ledPosition(i), ledSize * 0.7, ledSize * 0.3);
             if (updatedHit(hit, sd)) {
                 hit.ledIndex = i;
                 hit.material = LED_FRAME_MATERIAL;
             }
         }
-        sd = sdSphere(p, ledPosition[i].xyz, ledSize);
+        sd = sdSphere(p, ledPosition(i), ledSize);
         if (updatedHit(hit, sd)) {
             hit.ledIndex = i;
             hit.material = LED_MATERIAL;
@@ -473,7 +462,7 @@ vec3 opaqueMaterial(Marched hit, vec3 ray) {
             return c.yyy;
 
         case LED_MATERIAL:
-            return to_vec(ledColor[hit.ledIndex]);
+            return ledColor(hit.ledIndex);
 
         case FLOOR_MATERIAL:
             // Synthwave Grid ftw.
@@ -495,9 +484,9 @@ vec3 opaqueMaterial(Marched hit, vec3 ray) {
 
             vec3 lights = c.yyy;
             for (int i = 0; i < nLeds; i++) {
-                float sd = distance(ray, ledPosition[i].xyz);
+                float sd = distance(ray, ledPosition(i));
                 float w = exp(-ledGlow * sd);
-                lights += w * to_vec(ledColor[i]);
+                lights += w * ledColor(i);
             }
             base += lights / float(nLeds);
             return base;
@@ -538,62 +527,10 @@ Marched traceScene(Ray ray) {
     return hit;
 }
 
-const float goldenPhi = 2.39996323;
-
-vec3 blurredBloomImage(in vec2 st) {
-    vec4 result = c.yyyy;
-    for (float s = 0.; s < ledBlurSamples; s+= 1.) {
-        float r = ledBlurRadius * sqrt((s + 0.5) / ledBlurSamples) * 1./iResolution.y;
-        float theta = s * goldenPhi;
-        // theta += 0.05 * hash1(globalSeed);
-        vec2 offset = r * vec2(cos(theta), sin(theta));
-        r *= ledBlurPrecision * 0.01/ledSize;
-        float weight = exp(-r * r);
-        result.rgb += weight * texture(iBloomImage, st + offset).rgb;
-        result.a += weight;
-    }
-    return mix(
-        texture(iBloomImage, st).rgb,
-        result.rgb / result.a,
-        ledBlurMixing
-    );
-}
-
-const float postExposure = 1.2;
-const vec3 postGamma = vec3(0.8);
-
-void postProcess(inout vec3 col, in vec2 uv, in vec2 st) {
-    vec3 bloomImage = blurredBloomImage(st);
-    float brightness = 1.5 * dot(bloomImage, vec3(0.2126, 0.7152, 0.0722));
-//    brightness = pow(brightness, 0.5);
-//    col = mix(col + 0.1 * bloomImage, bloomImage, brightness);
-    col = mix(col, bloomImage, brightness);
-//    col = 1. - exp(-col * (postExposure + brightness));
-//    col = pow(col, postGamma);
-
-    // simple vignette for now.
-    float rf = length(uv) * 0.9;
-    rf = pow(rf, 4.2) + 1.;
-    rf = pow(rf, -1.6);
-    col *= clamp(rf, 0., 1.);
-
-    // gamma grading
-    // col = pow(col, vec3(1.4));
-    // gain
-    // col = col * 4.0/(2.5 + col);
-}
-
 void main() {
     vec2 uv = (2. * (gl_FragCoord.xy - iRect.xy) - iResolution) / iResolution.y;
 
-    // border frame
-    float uvX = uv.x / aspectRatio;
-    if (max(abs(uvX), abs(uv.y)) > 0.993) {
-        if (abs(uvX) >= abs(uv.y)) { // vertical frame?
-            fragColor.rgb = uvX < 0 ? borderDark : borderLight;
-        } else {
-            fragColor.rgb = uv.y > 0 ? borderDark : borderLight;
-        }
+    if (inBorderFrame(uv, fragColor.rgb)) {
         return;
     }
 
@@ -612,14 +549,13 @@ void main() {
         }
     }
 
-    vec3 lightDir = normalize(vec3(0,.125+.05*sin(.1*iTime),1));
     vec3 ro = vec3(camX, camY, camZ);
     vec3 rd;
     Ray ray;
     Marched hit;
 
     rd = normalize(vec3(uv, camFov));
-    rd *= rotateX(camTilt);
+    rd *= camRotation;
     fragColor.rgb = background(rd, lightDir);
 
     col = c.yyy;
@@ -648,6 +584,7 @@ void main() {
     vec4 previousImage = texture(iPreviousImage, st);
 
     if (iPass == POST_PASS) {
+        // only when TrophyShader::dedicatedPostPass is off, otherwise post.glsl does this without tracing
         col = previousImage.rgb / previousImage.a;
         col = max(col, fragColor.rgb);
         postProcess(col, uv, st);
@@ -676,4 +613,127 @@ void main() {
 )";
 
 
+extern const char embedded_post_shader[] = R"(
+#version 330 core
+
+// the POST_PASS on its own: composes what the SCENE_PASS accumulated with the bloom of the LEDs,
+// i.e. two texture reads (and the blur) per pixel instead of tracing the whole scene again.
+
+precision highp float;
+layout (location = 0) out vec4 fragColor;
+
+uniform sampler2D iAccumulatedImage;
+
+#include "common.glsl"
+
+void main() {
+    vec2 uv = (2. * (gl_FragCoord.xy - iRect.xy) - iResolution) / iResolution.y;
+
+    if (inBorderFrame(uv, fragColor.rgb)) {
+        fragColor.a = 1.;
+        return;
+    }
+
+    vec2 st = (gl_FragCoord.xy) / (iResolution + iRect.xy);
+    vec4 accumulated = texture(iAccumulatedImage, st);
+    // the alpha is the weight when accumulating forever, 1 otherwise
+    vec3 col = accumulated.rgb / accumulated.a;
+    postProcess(col, uv, st);
+    fragColor = vec4(col, 1.);
+}
+)";
+
+
+extern const char embedded_common_shader[] = R"(
+// what fragment.glsl and post.glsl both need, i.e. the parameters, the border frame and the post processing.
+// GLSL has no #include of its own, the TrophyShader puts this file in place of the `#include "common.glsl"` line.
+
+uniform vec4 iRect;
+uniform sampler2D iBloomImage;
+
+layout(std140) uniform StateBuffer {
+    float ledSize, ledGlow;
+    float camX, camY, camZ, camFov, camTilt;
+    float fogScaling, fogGrading, backgroundSpin;
+    float floorLevel, floorGraytone, floorLineBrightness,
+          floorSpacingX, floorSpacingZ,
+          floorLineWidth, floorExponent, floorGrading;
+    float pyramidX, pyramidY, pyramidZ,
+          pyramidScale, pyramidHeight,
+          pyramidAngle, pyramidAngularVelocity;
+    float epoxyPermittivity;
+    float blendPreviousMixing;
+    float traceMinDistance, traceMaxDistance, traceFixedStep;
+    int traceMaxSteps, traceMaxRecursions;
+    float ledBlurSamples, ledBlurRadius, ledBlurPrecision,
+          ledBlurMixing;
+};
+
+const vec4 c = vec4(1., 0., -1., .5);
+
+const vec3 borderDark = vec3(0.4);
+const vec3 borderLight = vec3(0.6);
+
+vec2 iResolution = iRect.zw;
+float aspectRatio = iResolution.x / iResolution.y;
+
+bool inBorderFrame(in vec2 uv, out vec3 col) {
+    float uvX = uv.x / aspectRatio;
+    if (max(abs(uvX), abs(uv.y)) <= 0.993) {
+        return false;
+    }
+    if (abs(uvX) >= abs(uv.y)) { // vertical frame?
+        col = uvX < 0 ? borderDark : borderLight;
+    } else {
+        col = uv.y > 0 ? borderDark : borderLight;
+    }
+    return true;
+}
+
+const float goldenPhi = 2.39996323;
+
+vec3 blurredBloomImage(in vec2 st) {
+    vec4 result = c.yyyy;
+    for (float s = 0.; s < ledBlurSamples; s+= 1.) {
+        float r = ledBlurRadius * sqrt((s + 0.5) / ledBlurSamples) * 1./iResolution.y;
+        float theta = s * goldenPhi;
+        // theta += 0.05 * hash1(globalSeed);
+        vec2 offset = r * vec2(cos(theta), sin(theta));
+        r *= ledBlurPrecision * 0.01/ledSize;
+        float weight = exp(-r * r);
+        result.rgb += weight * texture(iBloomImage, st + offset).rgb;
+        result.a += weight;
+    }
+    return mix(
+        texture(iBloomImage, st).rgb,
+        result.rgb / result.a,
+        ledBlurMixing
+    );
+}
+
+const float postExposure = 1.2;
+const vec3 postGamma = vec3(0.8);
+
+void postProcess(inout vec3 col, in vec2 uv, in vec2 st) {
+    vec3 bloomImage = blurredBloomImage(st);
+    float brightness = 1.5 * dot(bloomImage, vec3(0.2126, 0.7152, 0.0722));
+//    brightness = pow(brightness, 0.5);
+//    col = mix(col + 0.1 * bloomImage, bloomImage, brightness);
+    col = mix(col, bloomImage, brightness);
+//    col = 1. - exp(-col * (postExposure + brightness));
+//    col = pow(col, postGamma);
+
+    // simple vignette for now.
+    float rf = length(uv) * 0.9;
+    rf = pow(rf, 4.2) + 1.;
+    rf = pow(rf, -1.6);
+    col *= clamp(rf, 0., 1.);
+
+    // gamma grading
+    // col = pow(col, vec3(1.4));
+    // gain
+    // col = col * 4.0/(2.5 + col);
+}
+)";
+
 #endif //DLTROPHY_SIMULATOR_EMBEDDED_H
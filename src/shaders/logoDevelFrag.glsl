@@ -18,28 +18,30 @@ const int SCENE_PASS = 1;
 const int POST_PASS = 2;
 bool onlyLeds = iPass == ONLY_LEDS_PASS;
 
-const int nLeds = 172;
+uniform int nLeds;
 const int minLogoLed = 64;
 const int maxLogoLed = 167;
 
-layout(std140) uniform TrophyDefinition {
-    int _nLedsWouldNotWorkThatWay;
-    vec4 ledPosition[nLeds];
-};
+// texture buffers, so neither their size is fixed here nor are they padded to vec4 each
+uniform samplerBuffer ledPositions; // RGBA32F, xyz
+uniform samplerBuffer ledColors; // RGBA8, i.e. already normalized
 
-struct RGB { // last value is only for alignment, never used.
-    uint r, g, b, _;
-};
+vec3 ledPosition(int index) {
+    return texelFetch(ledPositions, index).xyz;
+}
+
+vec3 ledColor(int index) {
+    return texelFetch(ledColors, index).rgb;
+}
 
 layout(std140) uniform LogoStateBuffer {
-    RGB ledColor[nLeds];
     vec2 _logoCenter;
     vec2 logoSize;
     int options;
 };
 
 // QM took these as great examples of their kind, might make the logoCenter above superfluid
-vec2 logoCenter = vec2(ledPosition[127].x, ledPosition[131].y);
+vec2 logoCenter = vec2(ledPosition(127).x, ledPosition(131).y);
 const float freeScale = 1.3;
 
 #define hasOption(index) (options & (1 << (8 * index))) != 0
@@ -62,10 +64,6 @@ const vec2 epsilon = c.xz * 0.0005;
 const vec3 borderDark = vec3(0.4, 0.2, 0.2);
 const vec3 borderLight = vec3(0.8, 0.3, 0.3);
 
-vec3 to_vec(RGB rgb) {
-    return vec3(rgb.r, rgb.g, rgb.b) / 255.;
-}
-
 mat2 rot2D(float angle) {
     float c = cos(2*pi*angle);
     float s = sin(2*pi*angle);
@@ -277,7 +275,7 @@ void main() {
     vec2 pixelPos = c.yy;
     for (int i = minLogoLed; i <= maxLogoLed; i++) {
         // makeshift, but one could use any origin / scale -- this is about being useful quickly!
-        vec2 ledPos = (ledPosition[i].xy / logoSize.xx) - logoCenter;
+        vec2 ledPos = (ledPosition(i).xy / logoSize.xx) - logoCenter;
         d = sdfCircle(uv, ledPos, 0.01);
         if (d < dMin) {
             dMin = d;
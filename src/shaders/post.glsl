@@ -0,0 +1,27 @@
+#version 330 core
+
+// the POST_PASS on its own: composes what the SCENE_PASS accumulated with the bloom of the LEDs,
+// i.e. two texture reads (and the blur) per pixel instead of tracing the whole scene again.
+
+precision highp float;
+layout (location = 0) out vec4 fragColor;
+
+uniform sampler2D iAccumulatedImage;
+
+#include "common.glsl"
+
+void main() {
+    vec2 uv = (2. * (gl_FragCoord.xy - iRect.xy) - iResolution) / iResolution.y;
+
+    if (inBorderFrame(uv, fragColor.rgb)) {
+        fragColor.a = 1.;
+        return;
+    }
+
+    vec2 st = (gl_FragCoord.xy) / (iResolution + iRect.xy);
+    vec4 accumulated = texture(iAccumulatedImage, st);
+    // the alpha is the weight when accumulating forever, 1 otherwise
+    vec3 col = accumulated.rgb / accumulated.a;
+    postProcess(col, uv, st);
+    fragColor = vec4(col, 1.);
+}
@@ -0,0 +1,277 @@
+//
+// Created by qm210 on 16.10.2026.
+//
+
+// Measures the UDP decode path without any socket: ns per packet and heap allocations per packet,
+// then whole frames of 1k - 10k LEDs (as DNRGB packets, like WLED splits them) to check that it scales linearly,
+// a frame over several sACN universes and a DDP frame committed on PUSH.
+// For the delta protocol, compare its bytes and ns/packet against DRGB (all 172).
+// usage: ingest_bench [iterations]
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <vector>
+
+#define WORKAROUND_GL
+#include "UdpInterpreter.h"
+#include "DmxInterpreter.h"
+#include "DdpInterpreter.h"
+#include "messages.h"
+
+static std::atomic<size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations++;
+    if (void* pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+struct Fixture {
+    std::string name;
+    std::vector<uint8_t> packet;
+};
+
+void run(const Fixture& fixture, size_t nLeds, size_t iterations) {
+    std::vector<LED> leds(nLeds);
+    const PacketSource source = PacketSource::from("192.168.0.42", 21324);
+    size_t decodedLeds = 0;
+
+    // warm up, also lets the kernel selection happen outside the measurement
+    for (int i = 0; i < 100; i++) {
+        UdpInterpreter::interpret(fixture.packet, source, leds);
+    }
+
+    const size_t allocationsBefore = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto message = UdpInterpreter::interpret(fixture.packet, source, leds);
+        if (auto* decoded = std::get_if<ProtocolMessage>(&message)) {
+            decodedLeds += decoded->ledCount;
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const size_t allocationsDuring = allocations.load() - allocationsBefore;
+
+    const auto nanos = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::cout << std::left << std::setw(24) << fixture.name
+              << std::right << std::setw(6) << fixture.packet.size() << " bytes"
+              << std::setw(10) << std::fixed << std::setprecision(1) << nanos / iterations << " ns/packet"
+              << std::setw(8) << std::setprecision(3) << static_cast<double>(allocationsDuring) / iterations
+              << " allocs/packet"
+              << "  (" << decodedLeds / iterations << " LEDs)"
+              << std::endl;
+}
+
+void runFrame(size_t nLeds, size_t iterations) {
+    const size_t ledsPerPacket = 489;
+    // <-- what WLED puts into one DNRGB packet (fits the 1472 bytes of one unfragmented datagram)
+
+    std::vector<std::vector<uint8_t>> packets;
+    for (size_t start = 0; start < nLeds; start += ledsPerPacket) {
+        packets.push_back(createDNRGB(
+                static_cast<uint16_t>(start),
+                std::min(ledsPerPacket, nLeds - start),
+                [](size_t index) { return RGB(index, index >> 8, 7 * index); }
+        ));
+    }
+
+    std::vector<LED> leds(nLeds);
+    const PacketSource source = PacketSource::from("192.168.0.42", 21324);
+    size_t decodedLeds = 0;
+
+    const size_t allocationsBefore = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        for (const auto& packet : packets) {
+            auto message = UdpInterpreter::interpret(packet, source, leds);
+            if (auto* decoded = std::get_if<ProtocolMessage>(&message)) {
+                decodedLeds += decoded->ledCount;
+            }
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const size_t allocationsDuring = allocations.load() - allocationsBefore;
+
+    if (decodedLeds != nLeds * iterations || leds.back().b != static_cast<uint8_t>(7 * (nLeds - 1))) {
+        std::cerr << "[IngestBench] frame of " << nLeds << " LEDs was not decoded completely!" << std::endl;
+    }
+
+    const auto nanos = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::cout << std::setw(6) << nLeds << " LEDs"
+              << std::setw(4) << packets.size() << " packets"
+              << std::setw(12) << std::fixed << std::setprecision(1) << nanos << " ns/frame"
+              << std::setw(8) << std::setprecision(3) << nanos / nLeds << " ns/LED"
+              << std::setw(8) << std::setprecision(3) << static_cast<double>(allocationsDuring) / iterations
+              << " allocs/frame"
+              << std::endl;
+}
+
+void runDmxFrame(size_t nUniverses, size_t iterations) {
+    const size_t ledsPerUniverse = 170;
+    std::vector<DmxUniverseMapping> mappings;
+    for (size_t u = 0; u < nUniverses; u++) {
+        mappings.push_back({
+            .universe = static_cast<int>(u + 1),
+            .channel = 1,
+            .led = static_cast<int>(u * ledsPerUniverse),
+            .count = ledsPerUniverse,
+        });
+    }
+    DmxInterpreter dmx(mappings);
+    std::vector<LED> leds(nUniverses * ledsPerUniverse);
+
+    // the sequence number has to move on with every frame, so prepare all 256 of them
+    std::vector<std::vector<uint8_t>> packets;
+    for (size_t sequence = 0; sequence < 256; sequence++) {
+        for (size_t u = 0; u < nUniverses; u++) {
+            packets.push_back(createSacn(u + 1, sequence, ledsPerUniverse, [](size_t index) {
+                return RGB(index, 0, 255 - index);
+            }));
+        }
+    }
+
+    size_t frames = 0;
+    const size_t allocationsBefore = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        const auto sequence = i % 256;
+        for (size_t u = 0; u < nUniverses; u++) {
+            dmx.interpret(DmxProtocol::Sacn, packets[sequence * nUniverses + u], leds, [&frames] {
+                frames++;
+            });
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const size_t allocationsDuring = allocations.load() - allocationsBefore;
+
+    if (frames != iterations) {
+        std::cerr << "[IngestBench] only " << frames << " of " << iterations << " sACN frames were complete!" << std::endl;
+    }
+
+    const auto nanos = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::cout << std::setw(3) << nUniverses << " sACN universes"
+              << std::setw(12) << std::fixed << std::setprecision(1) << nanos << " ns/frame"
+              << std::setw(8) << std::setprecision(3) << nanos / leds.size() << " ns/LED"
+              << std::setw(8) << std::setprecision(3) << static_cast<double>(allocationsDuring) / iterations
+              << " allocs/frame"
+              << std::endl;
+}
+
+void runDdpFrame(size_t nLeds, size_t iterations) {
+    const size_t ledsPerPacket = 480;
+    // <-- what WLED puts into one DDP packet
+
+    // the sequence number moves on with every packet, WLED counts 1..15. So 15 frames, then it repeats.
+    std::vector<std::vector<std::vector<uint8_t>>> framePackets;
+    uint8_t sequence = 0;
+    for (size_t frame = 0; frame < 15; frame++) {
+        auto& packets = framePackets.emplace_back();
+        for (size_t start = 0; start < nLeds; start += ledsPerPacket) {
+            const size_t count = std::min(ledsPerPacket, nLeds - start);
+            sequence = sequence % 15 + 1;
+            packets.push_back(createDdp(
+                    3 * start,
+                    count,
+                    [](size_t index) { return RGB(index, index >> 8, 7 * index); },
+                    start + count == nLeds,
+                    sequence
+            ));
+        }
+    }
+
+    DdpInterpreter ddp(nLeds);
+    std::vector<LED> leds(nLeds);
+    size_t frames = 0;
+
+    const size_t allocationsBefore = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        for (const auto& packet : framePackets[i % framePackets.size()]) {
+            ddp.interpret(packet, [&](std::span<const LED> frame) {
+                std::copy(frame.begin(), frame.end(), leds.begin());
+                frames++;
+            });
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const size_t allocationsDuring = allocations.load() - allocationsBefore;
+
+    const auto stats = ddp.stats();
+    if (frames != iterations || stats.missingSegments > 0 || stats.missingPushes > 0
+        || leds.back().b != static_cast<uint8_t>(7 * (nLeds - 1))) {
+        std::cerr << "[IngestBench] only " << frames << " of " << iterations << " DDP frames were complete!" << std::endl;
+    }
+
+    const auto nanos = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::cout << std::setw(6) << nLeds << " LEDs via DDP"
+              << std::setw(12) << std::fixed << std::setprecision(1) << nanos << " ns/frame"
+              << std::setw(8) << std::setprecision(3) << nanos / nLeds << " ns/LED"
+              << std::setw(8) << std::setprecision(3) << static_cast<double>(allocationsDuring) / iterations
+              << " allocs/frame"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = 1000000;
+    if (argc > 1) {
+        iterations = std::stoul(argv[1]);
+    }
+
+    auto color = [](size_t index) {
+        return RGB(index, 255 - index, 3 * index);
+    };
+    std::vector<RGB> frame(N_LOGO + N_BASE + 2);
+    for (size_t index = 0; index < frame.size(); index++) {
+        frame[index] = color(index);
+    }
+    DeltaEncoder encoder;
+    const auto deltaKeyframe = encoder.encode(frame);
+    for (size_t dot = 0; dot < 8; dot++) {
+        frame[FIRST_BASE_INDEX + 3 * dot] = RGB(255, 255, 255);
+    }
+    const auto deltaFew = encoder.encode(frame);
+
+    const std::vector<Fixture> fixtures{
+        {"WARLS (all 172)", createWARLS(rangeOfAll(), color)},
+        {"WARLS (logo)", createWARLS(rangeOfLogo(), color)},
+        {"DRGB (all 172)", createDRGB(rangeOfAll(), color)},
+        {"DNRGB (base)", createDNRGB(FIRST_BASE_INDEX, N_BASE, color)},
+        {"Delta keyframe (all)", deltaKeyframe},
+        {"Delta (8 changed)", deltaFew},
+        {"garbage", {7, 0, 1, 2, 3}},
+    };
+
+    std::cout << "[IngestBench] " << iterations << " iterations, RGB kernel: "
+              << RgbKernel::selectedName() << std::endl;
+    for (const auto& fixture : fixtures) {
+        run(fixture, N_LOGO + N_BASE + 2, iterations);
+    }
+
+    std::cout << "[IngestBench] whole frames, ns/LED should stay about constant:" << std::endl;
+    for (size_t nLeds : {172, 1000, 2000, 5000, 10000}) {
+        runFrame(nLeds, std::max<size_t>(iterations / nLeds, 100));
+    }
+    for (size_t nUniverses : {1, 8, 32, 64}) {
+        runDmxFrame(nUniverses, std::max<size_t>(iterations / (170 * nUniverses), 100));
+    }
+    for (size_t nLeds : {172, 1000, 10000}) {
+        runDdpFrame(nLeds, std::max<size_t>(iterations / nLeds, 100));
+    }
+    return 0;
+}
@@ -32,6 +32,8 @@ const uint8_t N_BASE = 64;
 
 const uint8_t WARLS_HEADER = 1;
 const uint8_t DRGB_HEADER = 2;
+const uint8_t DNRGB_HEADER = 4;
+const uint8_t DELTA_HEADER = 200;
 
 const int timeout_sec = 255;
 
@@ -70,6 +72,181 @@ inline std::vector<uint8_t> createDRGB(
     return message;
 }
 
+inline std::vector<uint8_t> createDNRGB(
+        uint16_t startIndex,
+        size_t count,
+        const std::function<RGB(size_t)>& func
+) {
+    std::vector<uint8_t> message{
+        DNRGB_HEADER,
+        timeout_sec,
+        static_cast<uint8_t>(startIndex >> 8),
+        static_cast<uint8_t>(startIndex & 0xff)
+    };
+    for (size_t index = startIndex; index < startIndex + count; index++) {
+        auto led = func(index);
+        message.insert(message.end(), {led.r, led.g, led.b});
+    }
+    return message;
+}
+
+inline std::vector<uint8_t> createSacn(
+        uint16_t universe,
+        uint8_t sequence,
+        size_t count,
+        const std::function<RGB(size_t)>& func,
+        uint16_t syncAddress = 0
+) {
+    // E1.31 data packet, the RGB triples from DMX channel 1 on
+    const size_t nChannels = 3 * count;
+    std::vector<uint8_t> message(126 + nChannels, 0);
+    const uint8_t identifier[] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7'};
+    auto put16 = [&message](size_t at, size_t value) {
+        message[at] = static_cast<uint8_t>(value >> 8);
+        message[at + 1] = static_cast<uint8_t>(value & 0xff);
+    };
+    put16(0, 0x0010);
+    std::copy(std::begin(identifier), std::end(identifier), message.begin() + 4);
+    put16(16, 0x7000 | (message.size() - 16));
+    message[21] = 0x04;
+    put16(38, 0x7000 | (message.size() - 38));
+    message[43] = 0x02;
+    message[108] = 100;
+    put16(109, syncAddress);
+    message[111] = sequence;
+    put16(113, universe);
+    put16(115, 0x7000 | (message.size() - 115));
+    message[117] = 0x02;
+    message[118] = 0xa1;
+    put16(121, 1);
+    put16(123, nChannels + 1);
+    for (size_t i = 0; i < count; i++) {
+        auto led = func(i);
+        message[126 + 3 * i] = led.r;
+        message[126 + 3 * i + 1] = led.g;
+        message[126 + 3 * i + 2] = led.b;
+    }
+    return message;
+}
+
+inline std::vector<uint8_t> createArtDmx(
+        uint16_t universe,
+        uint8_t sequence,
+        size_t count,
+        const std::function<RGB(size_t)>& func
+) {
+    std::vector<uint8_t> message{
+        'A', 'r', 't', '-', 'N', 'e', 't', 0,
+        0x00, 0x50, // OpCode ArtDmx, little endian
+        0, 14, // protocol version
+        sequence,
+        0, // physical
+        static_cast<uint8_t>(universe & 0xff),
+        static_cast<uint8_t>((universe >> 8) & 0x7f),
+        static_cast<uint8_t>((3 * count) >> 8),
+        static_cast<uint8_t>((3 * count) & 0xff),
+    };
+    for (size_t i = 0; i < count; i++) {
+        auto led = func(i);
+        message.insert(message.end(), {led.r, led.g, led.b});
+    }
+    return message;
+}
+
+inline std::vector<uint8_t> createDdp(
+        uint32_t offset,
+        size_t count,
+        const std::function<RGB(size_t)>& func,
+        bool push,
+        uint8_t sequence = 0
+) {
+    // DDP data packet, version 1, RGB 8 bit, display 1 - the offset is in bytes, not in pixels
+    const size_t length = 3 * count;
+    std::vector<uint8_t> message{
+        static_cast<uint8_t>(0x40 | (push ? 0x01 : 0x00)),
+        static_cast<uint8_t>(sequence & 0x0f),
+        0x0b,
+        1,
+        static_cast<uint8_t>(offset >> 24),
+        static_cast<uint8_t>((offset >> 16) & 0xff),
+        static_cast<uint8_t>((offset >> 8) & 0xff),
+        static_cast<uint8_t>(offset & 0xff),
+        static_cast<uint8_t>(length >> 8),
+        static_cast<uint8_t>(length & 0xff),
+    };
+    for (size_t i = 0; i < count; i++) {
+        auto led = func(offset / 3 + i);
+        message.insert(message.end(), {led.r, led.g, led.b});
+    }
+    return message;
+}
+
+class DeltaEncoder {
+    // the sender side of RealtimeProtocol::Delta: every frame as XOR against the previous one,
+    // run-length encoded, and every keyframeInterval frames (or on request) one against black.
+    std::vector<RGB> previous;
+    uint8_t sequence = 0;
+    size_t keyframeInterval;
+    size_t sinceKeyframe = 0;
+
+public:
+    explicit DeltaEncoder(size_t keyframeInterval = 30)
+    : keyframeInterval(keyframeInterval)
+    {}
+
+    std::vector<uint8_t> encode(const std::vector<RGB>& frame, bool forceKeyframe = false) {
+        const bool keyframe = forceKeyframe
+                              || previous.size() != frame.size()
+                              || sinceKeyframe + 1 >= keyframeInterval;
+        if (keyframe) {
+            previous.assign(frame.size(), RGB());
+            sinceKeyframe = 0;
+        } else {
+            sinceKeyframe++;
+        }
+        sequence++;
+
+        std::vector<uint8_t> message{
+            DELTA_HEADER,
+            timeout_sec,
+            static_cast<uint8_t>(keyframe ? 0x01 : 0x00),
+            sequence,
+        };
+        auto same = [this, &frame](size_t index) {
+            return frame[index].r == previous[index].r
+                   && frame[index].g == previous[index].g
+                   && frame[index].b == previous[index].b;
+        };
+        size_t index = 0;
+        while (index < frame.size()) {
+            size_t count = 1;
+            const bool unchanged = same(index);
+            while (index + count < frame.size() && count < 128 && same(index + count) == unchanged) {
+                count++;
+            }
+            if (unchanged) {
+                if (!keyframe && index + count == frame.size()) {
+                    // the rest stays anyway
+                    break;
+                }
+                message.push_back(static_cast<uint8_t>(0x80 | (count - 1)));
+            } else {
+                message.push_back(static_cast<uint8_t>(count - 1));
+                for (size_t i = index; i < index + count; i++) {
+                    message.insert(message.end(), {
+                        static_cast<uint8_t>(frame[i].r ^ previous[i].r),
+                        static_cast<uint8_t>(frame[i].g ^ previous[i].g),
+                        static_cast<uint8_t>(frame[i].b ^ previous[i].b),
+                    });
+                }
+            }
+            index += count;
+        }
+        previous = frame;
+        return message;
+    }
+};
+
 inline auto asBytes(std::vector<int> const& range) {
     return std::vector<uint8_t>(range.begin(), range.end());
 }
@@ -10,7 +10,10 @@
 #include <algorithm>
 #include <MinimalSocket/udp/UdpSocket.h>
 #include <cmath>
+#include <chrono>
+#include <string>
 #include "messages.h"
+#include "SharedFrameRing.h"
 
 struct Message {
     std::vector<uint8_t> values;
@@ -144,7 +147,95 @@ std::vector<Message> createPattern(const std::string& patternName, bool useDrgb
     return pattern;
 }
 
-int main() {
+std::vector<RGB> benchFrame(size_t i) {
+    // like our effects mostly are: a dot running around the base, the logo only changes every second frame
+    std::vector<RGB> frame(N_LOGO + N_BASE + 2);
+    for (size_t index = 0; index < N_LOGO; index++) {
+        frame[index] = RGB(i / 2 + index, 40, 255 - i / 2);
+    }
+    for (size_t dot = 0; dot < 4; dot++) {
+        frame[FIRST_BASE_INDEX + (i + dot) % N_BASE] = RGB(255, 60 * dot, 0);
+    }
+    return frame;
+}
+
+void sendAtRate(MinimalSocket::udp::Udp<true>& sender,
+                const MinimalSocket::Address& remote,
+                int packetsPerSecond,
+                int seconds,
+                bool delta) {
+    // full-trophy frames (DRGB, or our delta protocol) as fast as the rate says, to benchmark the simulator ingest.
+    // sleep_for() is too coarse for 100k packets/s, so only sleep if there is time to spare.
+    auto allLeds = rangeOfAll();
+    auto interval = std::chrono::nanoseconds(1'000'000'000 / packetsPerSecond);
+    auto total = static_cast<size_t>(packetsPerSecond) * seconds;
+    DeltaEncoder encoder;
+    size_t bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    for (size_t i = 0; i < total; i++) {
+        auto frame = benchFrame(i);
+        auto values = delta
+            ? encoder.encode(frame)
+            : createDRGB(allLeds, [&frame](int index) { return frame[index]; });
+        bytes += values.size();
+        std::string message_string(values.begin(), values.end());
+        sender.sendTo(message_string, remote);
+
+        next += interval;
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next) {
+                break;
+            }
+            if (next - now > std::chrono::milliseconds(2)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Sent " << total << " packets in " << elapsed << " sec. -> "
+              << static_cast<double>(total) / elapsed << " packets/s (target " << packetsPerSecond << "), "
+              << static_cast<double>(bytes) / static_cast<double>(total) << " bytes/packet"
+              << (delta ? " as delta" : " as DRGB") << std::endl;
+}
+
+int writeShared(const std::string& name, int seconds) {
+    // full-trophy frames at 100 per second into the shared memory, for "sharedFrames" in the simulator config
+#ifdef _WIN32
+    std::cerr << "No shared memory frames on Windows." << std::endl;
+    return 1;
+#else
+    const uint32_t nLeds = N_LOGO + N_BASE;
+    auto* ring = dltrophy_ring_create(name.c_str(), nLeds);
+    if (ring == nullptr) {
+        std::cerr << "Cannot create the shared frame ring " << name << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> rgb(3 * nLeds);
+    const auto interval = std::chrono::milliseconds(10);
+    const auto total = 100 * seconds;
+    auto next = std::chrono::steady_clock::now();
+    for (int i = 0; i < total; i++) {
+        for (uint32_t index = 0; index < nLeds; index++) {
+            rgb[3 * index] = static_cast<uint8_t>(i + index);
+            rgb[3 * index + 1] = static_cast<uint8_t>(2 * i);
+            rgb[3 * index + 2] = static_cast<uint8_t>(255 - i);
+        }
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        dltrophy_ring_write(ring, rgb.data(), nLeds,
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+    std::cout << "Wrote " << total << " frames to " << name << std::endl;
+    dltrophy_ring_destroy(ring, name.c_str());
+    return 0;
+#endif
+}
+
+int main(int argc, char* argv[]) {
     std::cout << "Mock Sender: Test UDP package sending." << std::endl;
 
     Config config{
@@ -156,6 +247,36 @@ int main() {
             .debug = false,
     };
 
+    // usage:
+    //   mock_sender                         -> play the pattern above
+    //   mock_sender --rate 10000 [seconds]  -> send full frames at a fixed packet rate
+    //   mock_sender --bench [seconds]       -> do that for 1k, 10k and 100k packets/s,
+    //                                          compare with "UDP In" in the simulator panel.
+    //   mock_sender --shm /dltrophy [seconds] -> write frames into shared memory instead of sending them
+    //   --delta                             -> with --rate / --bench: send our delta protocol instead of DRGB
+    std::vector<int> rates;
+    bool delta = false;
+    std::string sharedName;
+    int seconds = 5;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--rate" && a + 1 < argc) {
+            rates.push_back(std::stoi(argv[++a]));
+        } else if (arg == "--bench") {
+            rates = {1000, 10000, 100000};
+        } else if (arg == "--delta") {
+            delta = true;
+        } else if (arg == "--shm" && a + 1 < argc) {
+            sharedName = argv[++a];
+        } else {
+            seconds = std::stoi(arg);
+        }
+    }
+
+    if (!sharedName.empty()) {
+        return writeShared(sharedName, seconds);
+    }
+
     const MinimalSocket::Address remote(config.host, config.port);
     MinimalSocket::udp::Udp<true> sender(
             MinimalSocket::ANY_PORT,
@@ -167,6 +288,15 @@ int main() {
         return 1;
     }
 
+    if (!rates.empty()) {
+        for (auto rate : rates) {
+            sendAtRate(sender, remote, rate, seconds, delta);
+            // give the simulator stats a moment to settle between the rates
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+        }
+        return 0;
+    }
+
     for (std::size_t i = 0; i <= config.repeats; i++) {
 
         for (const auto &message : config.messages) {